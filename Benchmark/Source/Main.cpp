@@ -0,0 +1,400 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 16 Oct 2026 11:02:45am
+    Author:  knize
+
+    Headless render benchmark for BasicEQAudioProcessor, built by BasicEQBenchmark.jucer
+    (which compiles the plugin sources with BASICEQ_PROFILE_STAGES=1).
+
+    BasicEQBenchmark [--rates=44100,48000,96000] [--blocks=32,64,128,256,512,1024,2048,4096]
+                     [--seconds=10] [--input=guitar.wav] [--irs=path/to/Data] [--headless] [--mono] [--csv]
+    BasicEQBenchmark --verify [--rates=...] [--blocks=...]
+
+    --input     real audio to render next to the synthetic signal
+    --irs       renders once per .wav found (recursively) in that folder, otherwise
+                the first shipped IR is used
+    --headless  nothing registered for analysis, as with no editor open. By default the
+                spectrum and meters are registered so their taps are measured too
+    --mono      mono bus layout, only the first channel of the input is rendered
+    --verify    instead of the render, checks that StereoBiquadCascade puts out the same as the two
+                MonoChains of juce::dsp::IIR::Filter it replaced and times both. Exits with 1 if it doesn't
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    const char* stageNames[NumProcessingStages] = { "eq", "convolution", "output gain", "metering", "analyzer taps" };
+
+    juce::Array<int> parseList(const juce::String& text, const juce::Array<int>& defaults)
+    {
+        if (text.isEmpty())
+            return defaults;
+
+        juce::StringArray tokens;
+        tokens.addTokens(text, ",", "");
+
+        juce::Array<int> values;
+        for (auto& token : tokens)
+            if (token.trim().getIntValue() > 0)
+                values.add(token.trim().getIntValue());
+
+        return values;
+    }
+
+    // noise under a slow log sine sweep, so every band of the EQ sees signal. Fixed seed, same input on every run
+    juce::AudioBuffer<float> makeSyntheticInput(double sampleRate, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer(2, numSamples);
+        juce::Random random(0x5eed);
+        double phase = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto freq = juce::mapToLog10((double)i / numSamples, 20.0, 20000.0);
+            phase += juce::MathConstants<double>::twoPi * freq / sampleRate;
+            const auto sweep = 0.25f * (float)std::sin(phase);
+
+            buffer.setSample(0, i, sweep + 0.1f * (random.nextFloat() * 2.f - 1.f));
+            buffer.setSample(1, i, sweep + 0.1f * (random.nextFloat() * 2.f - 1.f));
+        }
+
+        return buffer;
+    }
+
+    juce::AudioBuffer<float> readInput(const juce::File& file)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return {};
+
+        juce::AudioBuffer<float> buffer(2, (int)reader->lengthInSamples);
+        // mono files end up on both channels
+        reader->read(&buffer, 0, (int)reader->lengthInSamples, 0, true, true);
+        return buffer;
+    }
+
+    void setParameter(BasicEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* param = processor.apvts.getParameter(id);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    // --verify: every band is redesigned halfway through the stream and the slopes change, so the state
+    // carried from one set of coefficients to the next (and kept by stages that get bypassed) is covered too
+    struct EqCase
+    {
+        const char* name;
+        ChainSettings first, second;
+    };
+
+    ChainSettings makeSettings(float lowCutFreq, Slope lowCutSlope, float peakFreq, float peakGain, float peakQuality,
+                               float highCutFreq, Slope highCutSlope)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = lowCutFreq;
+        settings.lowCutSlope = lowCutSlope;
+        settings.peakFreq = peakFreq;
+        settings.peakGainInDecibels = peakGain;
+        settings.peakQuality = peakQuality;
+        settings.highCutFreq = highCutFreq;
+        settings.highCutSlope = highCutSlope;
+        return settings;
+    }
+
+    void setChain(MonoChain& chain, const ChainSettings& settings, double sampleRate)
+    {
+        updateCutFilter(chain.get<ChainPositions::LowCut>(), makeLowCutFilter(settings, sampleRate), settings.lowCutSlope);
+        updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, makePeakFilter(settings, sampleRate));
+        updateCutFilter(chain.get<ChainPositions::HighCut>(), makeHighCutFilter(settings, sampleRate), settings.highCutSlope);
+    }
+
+    void setCascade(StereoBiquadCascade& cascade, const ChainSettings& settings, double sampleRate)
+    {
+        // the processor's state slots: 0-3 low cut, 4 peak, 5-8 high cut
+        std::array<BiquadCoefficients, StereoBiquadCascade::MaxStages> stages;
+        std::array<int, StereoBiquadCascade::MaxStages> slots;
+        int numStages = 0;
+
+        const auto lowCut = makeLowCutFilter(settings, sampleRate);
+        for (int i = 0; i <= (int)settings.lowCutSlope; ++i)
+        {
+            stages[(size_t)numStages] = toBiquadCoefficients(*lowCut[i]);
+            slots[(size_t)numStages++] = i;
+        }
+
+        stages[(size_t)numStages] = toBiquadCoefficients(*makePeakFilter(settings, sampleRate));
+        slots[(size_t)numStages++] = 4;
+
+        const auto highCut = makeHighCutFilter(settings, sampleRate);
+        for (int i = 0; i <= (int)settings.highCutSlope; ++i)
+        {
+            stages[(size_t)numStages] = toBiquadCoefficients(*highCut[i]);
+            slots[(size_t)numStages++] = 5 + i;
+        }
+
+        cascade.setStages(stages.data(), slots.data(), numStages);
+    }
+
+    // largest difference in dB against the peak of the chains' output. Both compute the same operations
+    // in the same order, anything above the tolerance is a bug, not rounding
+    bool verifyCascade(double sampleRate, int blockSize)
+    {
+        constexpr float toleranceDecibels = -120.f;
+
+        const EqCase cases[] = {
+            { "steep cuts, peak moves",  makeSettings(80.f, Slope_48, 1500.f, 6.f, 1.f, 8000.f, Slope_48),
+                                         makeSettings(120.f, Slope_48, 400.f, -9.f, 4.f, 5000.f, Slope_48) },
+            { "slopes change",           makeSettings(80.f, Slope_48, 1500.f, 6.f, 1.f, 8000.f, Slope_24),
+                                         makeSettings(60.f, Slope_12, 3000.f, 3.f, 0.7f, 12000.f, Slope_48) },
+            { "low cut near DC",         makeSettings(10.f, Slope_48, 100.f, 12.f, 8.f, 20000.f, Slope_48),
+                                         makeSettings(20.f, Slope_36, 60.f, -12.f, 0.3f, 100.f, Slope_48) },
+        };
+
+        const auto numSamples = (int)sampleRate * 2;
+        const auto input = makeSyntheticInput(sampleRate, numSamples);
+        const juce::dsp::ProcessSpec monoSpec{ sampleRate, (juce::uint32)blockSize, 1 };
+        const juce::dsp::ProcessSpec stereoSpec{ sampleRate, (juce::uint32)blockSize, 2 };
+        auto passed = true;
+
+        for (const auto& eqCase : cases)
+        {
+            MonoChain left, right;
+            StereoBiquadCascade cascade;
+
+            setChain(left, eqCase.first, sampleRate);
+            setChain(right, eqCase.first, sampleRate);
+            left.prepare(monoSpec);
+            right.prepare(monoSpec);
+            cascade.prepare(stereoSpec);
+            setCascade(cascade, eqCase.first, sampleRate);
+
+            juce::AudioBuffer<float> reference(input), output(input);
+            juce::dsp::AudioBlock<float> referenceBlock(reference), outputBlock(output);
+            juce::int64 chainTicks = 0, cascadeTicks = 0;
+            auto switched = false;
+
+            for (int pos = 0; pos < numSamples; pos += blockSize)
+            {
+                if (!switched && pos >= numSamples / 2)
+                {
+                    setChain(left, eqCase.second, sampleRate);
+                    setChain(right, eqCase.second, sampleRate);
+                    setCascade(cascade, eqCase.second, sampleRate);
+                    switched = true;
+                }
+
+                const auto n = (size_t)juce::jmin(blockSize, numSamples - pos);
+                auto leftBlock = referenceBlock.getSubBlock((size_t)pos, n).getSingleChannelBlock(0);
+                auto rightBlock = referenceBlock.getSubBlock((size_t)pos, n).getSingleChannelBlock(1);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                left.process(juce::dsp::ProcessContextReplacing<float>(leftBlock));
+                right.process(juce::dsp::ProcessContextReplacing<float>(rightBlock));
+                const auto middle = juce::Time::getHighResolutionTicks();
+                cascade.process(outputBlock.getSubBlock((size_t)pos, n));
+                const auto end = juce::Time::getHighResolutionTicks();
+
+                chainTicks += middle - start;
+                cascadeTicks += end - middle;
+            }
+
+            float peak = 0.f, error = 0.f;
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    peak = juce::jmax(peak, std::abs(reference.getSample(ch, i)));
+                    error = juce::jmax(error, std::abs(reference.getSample(ch, i) - output.getSample(ch, i)));
+                }
+            }
+
+            const auto errorDecibels = juce::Decibels::gainToDecibels(error / juce::jmax(peak, 1.0e-30f), -200.f);
+            const auto ok = errorDecibels <= toleranceDecibels;
+            passed = passed && ok;
+
+            const auto toNsPerFrame = [numSamples](juce::int64 ticks) { return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / numSamples; };
+
+            juce::String line;
+            line << (ok ? "ok    " : "FAIL  ") << juce::String(eqCase.name).paddedRight(' ', 26) << (int)sampleRate << " Hz  block " << blockSize
+                 << "  difference " << juce::String(errorDecibels, 1) << " dB"
+                 << "  chains " << juce::String(toNsPerFrame(chainTicks), 2) << " ns/frame"
+                 << "  cascade " << juce::String(toNsPerFrame(cascadeTicks), 2) << " ns/frame\n";
+            std::cout << line;
+        }
+
+        return passed;
+    }
+
+    struct Result
+    {
+        std::array<double, NumProcessingStages> nsPerSample{};
+        double totalNsPerSample = 0;
+        int irSize = 0;
+    };
+
+    Result render(const juce::AudioBuffer<float>& input, double sampleRate, int blockSize, const juce::File& ir, bool headless, int numChannels)
+    {
+        BasicEQAudioProcessor processor;
+
+        if (!headless)
+        {
+            processor.addAnalysisConsumer(Analysis_Spectrum);
+            processor.addAnalysisConsumer(Analysis_Meters);
+        }
+
+        // all bands active at the steepest slopes, the worst case for the EQ
+        setParameter(processor, "LowCut Freq", 80.f);
+        setParameter(processor, "HighCut Freq", 8000.f);
+        setParameter(processor, "LowCut Slope", (float)Slope_48);
+        setParameter(processor, "HighCut Slope", (float)Slope_48);
+        setParameter(processor, "Peak Gain", 6.f);
+
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> block(numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        // the first shipped IR, from the pack or its WAV, unless a file was given
+        const auto loaded = ir.existsAsFile() ? processor.loadUserImpulseResponse(ir) : processor.updateLoadedIR(0, 0, 0, 0);
+
+        if (loaded != nullptr)
+        {
+            // the convolution picks up the new IR asynchronously while it is processing. A file at another rate
+            // is resampled on the IR bank's thread and loaded by the processor's async update, which needs a message loop
+            for (int attempt = 0; attempt < 5000 && processor.irLoader.getCurrentIRSize() == 0; ++attempt)
+            {
+                processor.dispatchPendingUpdates();
+                block.clear();
+                processor.processBlock(block, midi);
+                juce::Thread::sleep(1);
+            }
+        }
+
+        const auto numSamples = input.getNumSamples();
+        auto renderPass = [&]
+        {
+            for (int pos = 0; pos < numSamples; pos += blockSize)
+            {
+                const auto n = juce::jmin(blockSize, numSamples - pos);
+                block.setSize(numChannels, n, false, false, true);
+                for (int ch = 0; ch < numChannels; ++ch)
+                    block.copyFrom(ch, 0, input, ch, pos, n);
+
+                processor.processBlock(block, midi);
+            }
+        };
+
+        // one untimed pass to settle caches and the convolution state
+        renderPass();
+        processor.resetStageTicks();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        renderPass();
+        const auto total = juce::Time::getHighResolutionTicks() - start;
+
+        Result result;
+        const auto toNsPerSample = [numSamples](juce::int64 ticks) { return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / numSamples; };
+
+        for (int stage = 0; stage < NumProcessingStages; ++stage)
+            result.nsPerSample[stage] = toNsPerSample(processor.getStageTicks()[stage]);
+
+        result.totalNsPerSample = toNsPerSample(total);
+        result.irSize = processor.irLoader.getCurrentIRSize();
+        processor.releaseResources();
+        return result;
+    }
+
+    void print(const Result& result, const juce::String& signal, const juce::String& irName, double sampleRate, int blockSize, bool csv)
+    {
+        if (csv)
+        {
+            juce::String line;
+            line << signal << "," << irName << "," << (int)sampleRate << "," << blockSize << "," << result.irSize;
+            for (auto ns : result.nsPerSample)
+                line << "," << juce::String(ns, 3);
+            std::cout << (line << "," << juce::String(result.totalNsPerSample, 3)) << std::endl;
+            return;
+        }
+
+        juce::String line;
+        line << signal << "  " << irName << "  " << (int)sampleRate << " Hz  block " << blockSize << "  ir " << result.irSize << " smp\n";
+        for (int stage = 0; stage < NumProcessingStages; ++stage)
+            line << "    " << juce::String(stageNames[stage]).paddedRight(' ', 14) << juce::String(result.nsPerSample[stage], 3) << " ns/sample\n";
+        line << "    " << juce::String("total").paddedRight(' ', 14) << juce::String(result.totalNsPerSample, 3) << " ns/sample\n";
+        std::cout << line;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // the processor needs a message manager for its parameters, nothing is ever dispatched on it
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const auto rates = parseList(args.getValueForOption("--rates"), { 44100, 48000, 96000 });
+    const auto blocks = parseList(args.getValueForOption("--blocks"), { 32, 64, 128, 256, 512, 1024, 2048, 4096 });
+    const auto seconds = juce::jmax(1, args.containsOption("--seconds") ? args.getValueForOption("--seconds").getIntValue() : 10);
+    const auto csv = args.containsOption("--csv");
+    const auto headless = args.containsOption("--headless");
+    const auto numChannels = args.containsOption("--mono") ? 1 : 2;
+
+    if (args.containsOption("--verify"))
+    {
+        auto passed = true;
+        for (auto rate : rates)
+            for (auto blockSize : blocks)
+                passed = verifyCascade(rate, blockSize) && passed;
+
+        return passed ? 0 : 1;
+    }
+
+    juce::Array<juce::File> irs;
+    if (args.containsOption("--irs"))
+    {
+        for (const auto& entry : juce::RangedDirectoryIterator(args.getExistingFolderForOption("--irs"), true, "*.wav"))
+            irs.add(entry.getFile());
+
+        irs.sort();
+    }
+    if (irs.isEmpty())
+        irs.add(juce::File()); // default IR
+
+    juce::AudioBuffer<float> realInput;
+    if (args.containsOption("--input"))
+        realInput = readInput(args.getExistingFileForOption("--input"));
+
+    if (csv)
+        std::cout << "signal,ir,rate,block,irSize,eq,convolution,outputGain,metering,analyzerTaps,total" << std::endl;
+
+    for (auto rate : rates)
+    {
+        const auto numSamples = (int)(seconds * rate);
+        const auto synthetic = makeSyntheticInput(rate, numSamples);
+
+        for (auto blockSize : blocks)
+        {
+            for (const auto& ir : irs)
+            {
+                const auto irName = ir == juce::File() ? juce::String("default") : ir.getFileNameWithoutExtension();
+
+                print(render(synthetic, rate, blockSize, ir, headless, numChannels), "synthetic", irName, rate, blockSize, csv);
+
+                if (realInput.getNumSamples() > 0)
+                    print(render(realInput, rate, blockSize, ir, headless, numChannels), "input", irName, rate, blockSize, csv);
+            }
+        }
+    }
+
+    return 0;
+}
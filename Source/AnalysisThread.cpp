@@ -0,0 +1,22 @@
+/*
+  ==============================================================================
+
+    AnalysisThread.cpp
+    Created: 16 Oct 2026 5:21:37pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "AnalysisThread.h"
+
+AnalysisThread::AnalysisThread() : juce::TimeSliceThread("Analyzer")
+{
+    // below the message thread, with many editors open the host GUI comes first
+    startThread(3);
+}
+
+AnalysisThread::~AnalysisThread()
+{
+    stopThread(5000);
+}
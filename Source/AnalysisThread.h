@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    AnalysisThread.h
+    Created: 16 Oct 2026 5:21:37pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ one thread for every open editor of the plugin in the process. It turns analyzer fifo data and IRs into
+ paths, the message thread only picks up the finished geometry and paints it.
+ Held through a juce::SharedResourcePointer, so the first editor starts it and it goes away with the last one.
+ The spectrum and IR display are its juce::TimeSliceClients, each one is called about once per UI frame.
+ */
+class AnalysisThread : public juce::TimeSliceThread
+{
+public:
+    // what useTimeSlice() of a client returns while it is active
+    static constexpr int frameIntervalMs = 16;
+
+    AnalysisThread();
+    ~AnalysisThread() override;
+};
@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    ChainSettings.h
+    Created: 16 Oct 2026 8:11:52pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+enum Slope
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+enum Distance
+{
+    Distance_0,
+    Distance_10,
+    Distance_40
+};
+
+struct ChainSettings
+{
+    float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
+    float lowCutFreq{ 0 }, highCutFreq{ 0 };
+    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
+    int xPos{ 0 }, yPos{ Distance::Distance_0 };
+    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false }, irBypassed{ false };
+    float outputGainInDecibels{ 0 };
+};
@@ -0,0 +1,328 @@
+/*
+  ==============================================================================
+
+    EqKernelDesigner.cpp
+    Created: 16 Oct 2026 8:11:52pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "EqKernelDesigner.h"
+
+EqKernelDesigner::EqKernelDesigner(juce::AsyncUpdater& updater) : juce::Thread("EQ kernel designer"), onKernelReady(updater)
+{
+    startThread();
+}
+
+EqKernelDesigner::~EqKernelDesigner()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(5000);
+}
+
+void EqKernelDesigner::request(const Request& newRequest)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pending = newRequest;
+        hasPending = true;
+        ++generation;
+        result.reset();
+    }
+
+    notify();
+}
+
+void EqKernelDesigner::cancel()
+{
+    const juce::ScopedLock sl(lock);
+    hasPending = false;
+    pending.ir.reset();
+    ++generation;
+    result.reset();
+}
+
+std::shared_ptr<const ImpulseResponse> EqKernelDesigner::takeResult(Phase* phase)
+{
+    const juce::ScopedLock sl(lock);
+    if (phase != nullptr)
+        *phase = resultPhase;
+
+    return std::move(result);
+}
+
+double EqKernelDesigner::getTargetMagnitude(const ChainSettings& s, double frequency)
+{
+    double magnitude = 1.0;
+
+    if (!s.lowCutBypassed)
+    {
+        const auto order = 2 * (s.lowCutSlope + 1);
+        const auto r = std::pow(frequency / juce::jmax(2.0, (double)s.lowCutFreq), 2.0 * order);
+        magnitude *= std::sqrt(r / (1.0 + r));
+    }
+
+    if (!s.highCutBypassed)
+    {
+        const auto order = 2 * (s.highCutSlope + 1);
+        const auto r = std::pow(frequency / juce::jmax(2.0, (double)s.highCutFreq), 2.0 * order);
+        magnitude *= std::sqrt(1.0 / (1.0 + r));
+    }
+
+    if (!s.peakBypassed)
+    {
+        // (s^2 + s A/Q + 1) / (s^2 + s / (A Q) + 1) at s = j w
+        const auto a = std::pow(10.0, s.peakGainInDecibels / 40.0);
+        const auto q = (double)s.peakQuality;
+        const auto w = frequency / juce::jmax(2.0, (double)s.peakFreq);
+        const auto real = 1.0 - w * w;
+        const auto boost = w * a / q, cut = w / (a * q);
+        magnitude *= std::sqrt((real * real + boost * boost) / (real * real + cut * cut));
+    }
+
+    return magnitude;
+}
+
+int EqKernelDesigner::getLatency(Phase phase, double sampleRate)
+{
+    return phase == Phase_Linear ? getLength(sampleRate) / 2 : 0;
+}
+
+void EqKernelDesigner::run()
+{
+    while (!threadShouldExit())
+    {
+        Request work;
+        bool hasWork;
+        juce::uint32 workGeneration;
+        {
+            // requests that came in while the last design was running collapse into the newest one
+            const juce::ScopedLock sl(lock);
+            work = pending;
+            hasWork = hasPending;
+            workGeneration = generation;
+            hasPending = false;
+            pending.ir.reset();
+        }
+
+        if (!hasWork || work.sampleRate <= 0)
+        {
+            wait(-1);
+            continue;
+        }
+
+        // a newer request or cancel() wakes this up early, the newer one then starts its own wait
+        if (work.settleMs > 0)
+        {
+            wait(work.settleMs);
+
+            const juce::ScopedLock sl(lock);
+            if (generation != workGeneration || threadShouldExit())
+                continue;
+        }
+
+        const auto fir = work.phase == Phase_Iir ? render(work.iir, work.sampleRate)
+                                                 : design(work.chainSettings, work.sampleRate, work.phase);
+
+        // the live chain just keeps running, there's nothing to hand over
+        if (work.phase == Phase_Iir && !isWorthFreezing(work, (int)fir.size()))
+            continue;
+
+        auto kernel = merge(work.ir.get(), fir, work.sampleRate);
+
+        {
+            const juce::ScopedLock sl(lock);
+            if (generation != workGeneration)
+                continue;
+
+            result = std::move(kernel);
+            resultPhase = work.phase;
+        }
+
+        onKernelReady.triggerAsyncUpdate();
+    }
+}
+
+bool EqKernelDesigner::isWorthFreezing(const Request& request, int renderedLength)
+{
+    const auto irLength = request.ir != nullptr && request.ir->sampleRate > 0
+                        ? juce::roundToInt(request.ir->buffer.getNumSamples() * request.sampleRate / request.ir->sampleRate) : 0;
+    const auto added = PartitionedConvolution::getRelativeCost(irLength + renderedLength - 1)
+                     - PartitionedConvolution::getRelativeCost(irLength);
+
+    // a biquad on both channels is about three quarters of a partition (3.1 against 4.2 ns per stereo frame),
+    // oversampled it runs that many times as often. The oversampling filters themselves aren't counted
+    const auto live = 0.75 * request.iir.numStages * (1 << request.iir.oversampling);
+    return added <= live;
+}
+
+std::vector<float> EqKernelDesigner::design(const ChainSettings& chainSettings, double sampleRate, Phase phase)
+{
+    const auto length = getLength(sampleRate);
+    std::vector<float> fir((size_t)length, 0.f);
+
+    if (phase == Phase_Linear)
+    {
+        // zero phase spectrum (real and even), every bin given for the inverse transform
+        juce::dsp::FFT fft(juce::roundToInt(std::log2(length)));
+        std::vector<float> data((size_t)(2 * length), 0.f);
+        for (int k = 0; k < length; ++k)
+            data[(size_t)(2 * k)] = (float)getTargetMagnitude(chainSettings, juce::jmin(k, length - k) * sampleRate / length);
+
+        fft.performRealOnlyInverseTransform(data.data());
+
+        // centred on length / 2, the window is symmetric around it as well
+        for (int n = 0; n < length; ++n)
+        {
+            const auto phi = juce::MathConstants<double>::twoPi * n / length;
+            const auto window = 0.42 - 0.5 * std::cos(phi) + 0.08 * std::cos(2.0 * phi);
+            fir[(size_t)n] = (float)(data[(size_t)((n + length / 2) % length)] * window);
+        }
+
+        return fir;
+    }
+
+    // minimum phase: the causal part of the real cepstrum of the log magnitude, on a finer grid so it hardly aliases
+    const auto size = 4 * length;
+    juce::dsp::FFT fft(juce::roundToInt(std::log2(size)));
+    std::vector<std::complex<float>> a((size_t)size), b((size_t)size);
+
+    for (int k = 0; k < size; ++k)
+    {
+        const auto magnitude = getTargetMagnitude(chainSettings, juce::jmin(k, size - k) * sampleRate / size);
+        a[(size_t)k] = (float)std::log(juce::jmax(1.0e-5, magnitude));   // floor at -100 dB
+    }
+
+    fft.perform(a.data(), b.data(), true);
+
+    a[0] = b[0].real();
+    for (int n = 1; n < size / 2; ++n)
+        a[(size_t)n] = 2.f * b[(size_t)n].real();
+    a[(size_t)(size / 2)] = b[(size_t)(size / 2)].real();
+    std::fill(a.begin() + size / 2 + 1, a.end(), std::complex<float>());
+
+    fft.perform(a.data(), b.data(), false);
+    for (auto& bin : b)
+        bin = std::exp(bin);
+    fft.perform(b.data(), a.data(), true);
+
+    // the last quarter fades out, the response has long decayed there for anything but the lowest low cuts
+    const auto fadeStart = length - length / 4;
+    for (int n = 0; n < length; ++n)
+    {
+        const auto fade = n < fadeStart ? 1.f : 0.5f * (1.f + std::cos(juce::MathConstants<float>::pi * (float)(n - fadeStart) / (float)(length - fadeStart)));
+        fir[(size_t)n] = a[(size_t)n].real() * fade;
+    }
+
+    return fir;
+}
+
+std::vector<float> EqKernelDesigner::render(const IirChain& chain, double sampleRate)
+{
+    constexpr int blockSize = 4096;
+    const auto factor = 1 << chain.oversampling;
+
+    StereoBiquadCascade cascade;
+    cascade.prepare({ sampleRate * factor, (juce::uint32)(blockSize * factor), 1 });
+    cascade.setStages(chain.stages.data(), chain.slots.data(), chain.numStages);
+
+    // the same half band filters as the live path, they bring their latency along
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    if (chain.oversampling > 0)
+    {
+        oversampler = std::make_unique<juce::dsp::Oversampling<float>>(1, chain.oversampling,
+            juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, true);
+        oversampler->initProcessing((size_t)blockSize);
+    }
+
+    std::vector<float> response((size_t)(chain.oversampling > 0 ? 0 : chain.delay), 0.f);
+    juce::AudioBuffer<float> buffer(1, blockSize);
+    const auto maxLength = juce::roundToInt(2.0 * sampleRate);
+    auto peak = 0.f;
+
+    // block by block until one comes out 120 dB below the peak, or two seconds
+    for (int blockIndex = 0; (int)response.size() < maxLength; ++blockIndex)
+    {
+        buffer.clear();
+        if (blockIndex == 0)
+            buffer.setSample(0, 0, 1.f);
+
+        juce::dsp::AudioBlock<float> block(buffer);
+        if (oversampler != nullptr)
+        {
+            auto oversampled = oversampler->processSamplesUp(block);
+            cascade.process(oversampled);
+            oversampler->processSamplesDown(block);
+        }
+        else
+        {
+            cascade.process(block);
+        }
+
+        const auto magnitude = buffer.getMagnitude(0, 0, blockSize);
+        peak = juce::jmax(peak, magnitude);
+        response.insert(response.end(), buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize);
+
+        if (blockIndex > 0 && magnitude < peak * 1.0e-6f)
+            break;
+    }
+
+    return response;
+}
+
+std::shared_ptr<const ImpulseResponse> EqKernelDesigner::merge(const ImpulseResponse* ir, const std::vector<float>& fir, double sampleRate)
+{
+    auto kernel = std::make_shared<ImpulseResponse>();
+    kernel->sampleRate = sampleRate;
+
+    if (ir == nullptr)
+    {
+        kernel->buffer.setSize(1, (int)fir.size());
+        kernel->buffer.copyFrom(0, 0, fir.data(), (int)fir.size());
+        return kernel;
+    }
+
+    // IRs from the bank are at the session rate already
+    std::shared_ptr<const ImpulseResponse> resampled;
+    if (juce::roundToInt(ir->sampleRate) != juce::roundToInt(sampleRate))
+    {
+        resampled = IrBank::resample(*ir, sampleRate);
+        ir = resampled.get();
+    }
+
+    const auto irLength = ir->buffer.getNumSamples();
+    const auto length = irLength + (int)fir.size() - 1;
+    const auto fftSize = juce::nextPowerOfTwo(length);
+    const auto numBins = fftSize / 2 + 1;
+    juce::dsp::FFT fft(juce::roundToInt(std::log2(fftSize)));
+
+    std::vector<float> firSpectrum((size_t)(2 * fftSize), 0.f), work((size_t)(2 * fftSize), 0.f);
+    std::copy(fir.begin(), fir.end(), firSpectrum.begin());
+    fft.performRealOnlyForwardTransform(firSpectrum.data(), true);
+
+    const auto* h = reinterpret_cast<const std::complex<float>*>(firSpectrum.data());
+    auto* bins = reinterpret_cast<std::complex<float>*>(work.data());
+
+    kernel->buffer.setSize(ir->buffer.getNumChannels(), length);
+    kernel->normalisationGain = ir->normalisationGain;
+
+    for (int ch = 0; ch < ir->buffer.getNumChannels(); ++ch)
+    {
+        std::fill(work.begin(), work.end(), 0.f);
+        std::copy_n(ir->buffer.getReadPointer(ch), irLength, work.data());
+        fft.performRealOnlyForwardTransform(work.data(), true);
+
+        // mirrored for the inverse transform, JUCE's inverse already divides by the size
+        for (int k = 0; k < numBins; ++k)
+            bins[k] *= h[k];
+        for (int k = numBins; k < fftSize; ++k)
+            bins[k] = std::conj(bins[fftSize - k]);
+
+        fft.performRealOnlyInverseTransform(work.data());
+        kernel->buffer.copyFrom(ch, 0, work.data(), length);
+    }
+
+    return kernel;
+}
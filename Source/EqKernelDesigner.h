@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    EqKernelDesigner.h
+    Created: 16 Oct 2026 8:11:52pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "IrBank.h"
+#include "StereoBiquadCascade.h"
+#include "PartitionedConvolution.h"
+
+/**
+ builds the convolution kernel for the FIR EQ modes.
+ The FIR is designed from the magnitude of the analog prototypes of all active bands (Butterworth cuts,
+ RBJ peak), so unlike the bilinear IIR designs it doesn't cramp towards Nyquist. Linear phase is a
+ frequency sampled, Blackman windowed design that delays by half its length, minimum phase comes out
+ of the folded real cepstrum of the same magnitude and has no latency.
+ Phase_Iir freezes the IIR EQ instead: an impulse is run through the very biquads (and oversampler) the
+ audio thread runs, until its tail has died away, so the kernel sounds exactly like the live chain.
+ That tail makes the kernel longer, so it is only handed out if the partitions it adds cost less than the
+ biquads it replaces (a steep low cut rings for hundreds of ms), otherwise the live chain keeps running.
+ The FIR is then convolved with the cabinet IR, so the plugin runs one convolution for both.
+ Runs on its own thread, only the newest request is worked on, and a result is only handed out
+ if no request or cancel() came after it.
+ */
+class EqKernelDesigner : private juce::Thread
+{
+public:
+    enum Phase
+    {
+        Phase_Linear,
+        Phase_Minimum,
+        Phase_Iir   // the IIR EQ as it runs, phase and all
+    };
+
+    // the IIR EQ as processBlock() runs it, for Phase_Iir
+    struct IirChain
+    {
+        std::array<BiquadCoefficients, StereoBiquadCascade::MaxStages> stages;
+        std::array<int, StereoBiquadCascade::MaxStages> slots{};
+        int numStages = 0;
+        int oversampling = 0;   // designed for the session rate times 2^oversampling
+        int delay = 0;          // samples the session rate path is delayed by
+    };
+
+    struct Request
+    {
+        ChainSettings chainSettings;
+        double sampleRate = 0;
+        Phase phase = Phase_Linear;
+        std::shared_ptr<const ImpulseResponse> ir;   // nullptr for the EQ on its own
+        IirChain iir;
+        int settleMs = 0;   // only starts once no other request came in for this long
+    };
+
+    // onKernelReady is triggered (from the designer thread) when takeResult() has something new
+    explicit EqKernelDesigner(juce::AsyncUpdater& onKernelReady);
+    ~EqKernelDesigner() override;
+
+    void request(const Request& newRequest);
+    // drops what is pending, running or finished but not taken yet
+    void cancel();
+    // phase gets what the result was designed as
+    std::shared_ptr<const ImpulseResponse> takeResult(Phase* phase = nullptr);
+
+    // samples the EQ delays by in this mode. Phase_Iir kernels carry the delay of the live chain instead
+    static int getLatency(Phase phase, double sampleRate);
+
+    // |H| of the analog prototypes the IIR bands are bilinear transforms of, what the FIR modes are designed from
+    static double getTargetMagnitude(const ChainSettings& chainSettings, double frequency);
+
+    static std::vector<float> design(const ChainSettings& chainSettings, double sampleRate, Phase phase);
+    static std::vector<float> render(const IirChain& chain, double sampleRate);
+
+    // the IR convolved with the FIR, keeping the normalisation of the IR. Without an IR it's the FIR itself
+    static std::shared_ptr<const ImpulseResponse> merge(const ImpulseResponse* ir, const std::vector<float>& fir, double sampleRate);
+private:
+    // about a quarter of a second, enough resolution for a steep low cut down at 20 Hz
+    static int getLength(double sampleRate) { return juce::nextPowerOfTwo(juce::roundToInt(sampleRate / 4.0)); }
+    // false if convolving the rendered IIR EQ into the IR costs more than running it live
+    static bool isWorthFreezing(const Request& request, int renderedLength);
+
+    void run() override;
+
+    juce::AsyncUpdater& onKernelReady;
+    juce::CriticalSection lock;
+    Request pending;
+    bool hasPending = false;
+    juce::uint32 generation = 0;   // counts request() and cancel() calls
+    std::shared_ptr<const ImpulseResponse> result;
+    Phase resultPhase = Phase_Linear;
+};
@@ -10,6 +10,34 @@
 
 #include "HorizontalMeter.h"
 
+namespace
+{
+    int barWidth(float level, int width)
+    {
+        return juce::roundToInt(juce::jmap(juce::jlimit(-60.f, 6.f, level), -60.f, +6.f, 0.f, static_cast<float>(width)));
+    }
+}
+
+void HorizontalMeterLeft::setLevel(const float value, const float peakValue)
+{
+    const auto moved = barWidth(value, getWidth()) != barWidth(level, getWidth())
+                    || barWidth(peakValue, getWidth()) != barWidth(peak, getWidth());
+    level = value;
+    peak = peakValue;
+    if (moved)
+        repaint();
+}
+
+void HorizontalMeterRight::setLevel(const float value, const float peakValue)
+{
+    const auto moved = barWidth(value, getWidth()) != barWidth(level, getWidth())
+                    || barWidth(peakValue, getWidth()) != barWidth(peak, getWidth());
+    level = value;
+    peak = peakValue;
+    if (moved)
+        repaint();
+}
+
 void HorizontalMeterLeft::paint(juce::Graphics& g)
 {
     using namespace juce;
@@ -23,6 +51,9 @@ void HorizontalMeterLeft::paint(juce::Graphics& g)
     const auto scaledX = jmap(level, -60.f, +6.f, 0.f, static_cast<float>(getWidth()));
     g.fillRoundedRectangle(bounds.removeFromRight(scaledX), 5.f);
 
+    g.setColour(Colours::white);
+    g.fillRect((float)(getWidth() - barWidth(peak, getWidth())), r.getY() + 3.f, 2.f, r.getHeight() - 6.f);
+
     g.setColour(Colours::silver);
     g.drawRoundedRectangle(r, 5.f, 5.f);
 
@@ -41,6 +72,9 @@ void HorizontalMeterRight::paint(juce::Graphics& g)
     const auto scaledX = jmap(level, -60.f, +6.f, 0.f, static_cast<float>(getWidth()));
     g.fillRoundedRectangle(bounds.removeFromLeft(scaledX), 5.f);
 
+    g.setColour(Colours::white);
+    g.fillRect((float)barWidth(peak, getWidth()) - 2.f, r.getY() + 3.f, 2.f, r.getHeight() - 6.f);
+
 
     g.setColour(Colours::silver);
     g.drawRoundedRectangle(r, 5.f, 5.f);
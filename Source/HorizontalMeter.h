@@ -16,18 +16,20 @@ struct HorizontalMeterLeft : public juce::Component
 {
 public:
     void paint(juce::Graphics& g) override;
-    void setLevel(const float value) { level = value; }
+    // RMS as the bar, (true) peak as a line. Repaints only when either moves by a pixel
+    void setLevel(const float value, const float peakValue);
 
 private:
-    float level = -60.f;
+    float level = -60.f, peak = -60.f;
 };
 
 struct HorizontalMeterRight : public juce::Component
 {
 public:
     void paint(juce::Graphics& g) override;
-    void setLevel(const float value) { level = value; }
+    // RMS as the bar, (true) peak as a line. Repaints only when either moves by a pixel
+    void setLevel(const float value, const float peakValue);
 
 private:
-    float level = -60.f;
+    float level = -60.f, peak = -60.f;
 };
\ No newline at end of file
@@ -0,0 +1,545 @@
+/*
+  ==============================================================================
+
+    IrBank.cpp
+    Created: 16 Oct 2026 1:18:32pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "IrBank.h"
+#include "IrPack.h"
+
+IrBank::IrBank() : juce::Thread("IR bank")
+{
+    startThread();
+}
+
+IrBank::~IrBank()
+{
+    stopThread(5000);
+}
+
+void IrBank::prepare(const IrCatalogue::Table& table, double sampleRate)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        cacheFolder = table.cacheFolder;
+        packFile = table.packFile;
+        packSources = table.sources;
+
+        for (int slot = 0; slot < numSlots; ++slot)
+        {
+            const auto packIndex = table.pack != nullptr ? table.pack->find(IrCatalogue::getPosition(slot)) : -1;
+            const auto source = packIndex >= 0 ? SlotSource{ table.pack->getFile(), table.pack, packIndex }
+                                               : SlotSource{ table.files[(size_t)slot], nullptr, -1 };
+
+            if (source != sources[slot])
+            {
+                sources[slot] = source;
+                originals[slot].reset();
+                for (auto& rate : resampled)
+                    rate.second[slot].reset();
+            }
+        }
+
+        const auto rate = juce::roundToInt(sampleRate);
+        if (rate > 0 && std::find(rates.begin(), rates.end(), rate) == rates.end())
+            rates.push_back(rate);
+    }
+
+    // the background thread picks up new rates and slots after the pass it is in
+    notify();
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::get(int comboType, int mikType, int yPos, int xPos, double sampleRate)
+{
+    const auto slot = IrCatalogue::getSlot(comboType, mikType, yPos, xPos);
+    if (slot < 0)
+        return nullptr;
+
+    const auto rate = juce::roundToInt(sampleRate);
+    {
+        const juce::ScopedLock sl(lock);
+        if (rate <= 0 && originals[slot] != nullptr)
+            return originals[slot];
+        if (rate > 0 && resampled[rate][slot] != nullptr)
+            return resampled[rate][slot];
+    }
+
+    // not built yet, don't wait for the background thread
+    return build(slot, rate);
+}
+
+void IrBank::requestResample(juce::AsyncUpdater& owner, std::shared_ptr<const ImpulseResponse> ir, double sampleRate)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        resampleJobs[&owner] = { std::move(ir), nullptr, sampleRate };
+    }
+
+    notify();
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::takeResampled(juce::AsyncUpdater& owner)
+{
+    const juce::ScopedLock sl(lock);
+    const auto job = resampleJobs.find(&owner);
+    if (job == resampleJobs.end() || job->second.result == nullptr)
+        return nullptr;
+
+    auto result = std::move(job->second.result);
+    resampleJobs.erase(job);
+    return result;
+}
+
+void IrBank::cancelResample(juce::AsyncUpdater& owner)
+{
+    const juce::ScopedLock sl(lock);
+    resampleJobs.erase(&owner);
+}
+
+void IrBank::runResampleJobs()
+{
+    for (;;)
+    {
+        juce::AsyncUpdater* owner = nullptr;
+        ResampleJob job;
+        {
+            const juce::ScopedLock sl(lock);
+            for (const auto& pending : resampleJobs)
+            {
+                if (pending.second.result == nullptr)
+                {
+                    owner = pending.first;
+                    job = pending.second;
+                    break;
+                }
+            }
+        }
+
+        if (owner == nullptr || threadShouldExit())
+            return;
+
+        auto result = resample(*job.source, job.sampleRate);
+
+        // triggered under the lock, so cancelResample() can't return in between and leave owner to be triggered after it was deleted
+        const juce::ScopedLock sl(lock);
+        const auto current = resampleJobs.find(owner);
+        if (current != resampleJobs.end() && current->second.result == nullptr
+            && current->second.source == job.source && current->second.sampleRate == job.sampleRate)
+        {
+            current->second.result = std::move(result);
+            owner->triggerAsyncUpdate();
+        }
+    }
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::build(int slot, int rate)
+{
+    SlotSource source;
+    std::shared_ptr<const ImpulseResponse> original;
+    {
+        const juce::ScopedLock sl(lock);
+        source = sources[slot];
+        original = originals[slot];
+    }
+
+    if (original == nullptr)
+    {
+        int onset = 0;
+        original = source.pack != nullptr ? source.pack->read(source.packIndex) : decode(source.file, &onset);
+        if (original == nullptr)
+            return nullptr;
+
+        const juce::ScopedLock sl(lock);
+        if (sources[slot] == source && originals[slot] == nullptr)
+        {
+            originals[slot] = original;
+            onsets[slot] = source.pack != nullptr ? source.pack->getInfo(source.packIndex).onset : onset;
+        }
+    }
+
+    if (rate <= 0)
+        return original;
+
+    auto ir = readCached(source, slot, rate);
+    if (ir == nullptr)
+    {
+        ir = resample(*original, rate);
+        writeCached(source, slot, *ir, rate);
+    }
+
+    const juce::ScopedLock sl(lock);
+    auto& entry = resampled[rate][slot];
+    if (sources[slot] == source && entry == nullptr)
+        entry = ir;
+
+    return ir;
+}
+
+void IrBank::run()
+{
+    while (!threadShouldExit())
+    {
+        runResampleJobs();
+
+        std::vector<int> toBuild;
+        {
+            const juce::ScopedLock sl(lock);
+            toBuild = rates;
+        }
+
+        // the originals first, they are all the pack needs
+        toBuild.insert(toBuild.begin(), 0);
+
+        for (const auto rate : toBuild)
+        {
+            for (int slot = 0; slot < numSlots && !threadShouldExit(); ++slot)
+            {
+                // someone is waiting for those, nobody for the shipped IRs
+                runResampleJobs();
+
+                {
+                    const juce::ScopedLock sl(lock);
+                    if (!sources[slot].exists())
+                        continue;
+                    if (rate <= 0 ? originals[slot] != nullptr : resampled[rate][slot] != nullptr)
+                        continue;
+                }
+
+                build(slot, rate);
+            }
+        }
+
+        if (!threadShouldExit())
+            writePack();
+
+        // until prepare() brings another rate or other sources, or there is something to resample
+        wait(-1);
+    }
+}
+
+void IrBank::writePack()
+{
+    std::vector<IrPack::Source> packed;
+    juce::File target;
+    IrCatalogue::Fingerprint fingerprint;
+    {
+        const juce::ScopedLock sl(lock);
+        if (packFile == juce::File())
+            return;
+
+        // only a complete set from the WAVs. A pack the catalogue took is up to date already
+        for (int slot = 0; slot < numSlots; ++slot)
+        {
+            if (!sources[slot].exists())
+                continue;
+            if (sources[slot].pack != nullptr || originals[slot] == nullptr)
+                return;
+
+            packed.push_back({ IrCatalogue::getPosition(slot), originals[slot], onsets[slot] });
+        }
+
+        target = packFile;
+        fingerprint = packSources;
+    }
+
+    // another process may have written it meanwhile
+    if (auto existing = IrPack::open(target))
+        if (existing->getSources() == fingerprint)
+            return;
+
+    if (!packed.empty() && target.getParentDirectory().createDirectory())
+        IrPack::write(target, packed, BASICEQ_IR_PACK_HALF ? IrPack::Format_Half : IrPack::Format_Float32, fingerprint);
+}
+
+juce::File IrBank::getRateFolder(const juce::File& folder, int rate)
+{
+    // what an older decode() left there doesn't match the sources any more
+    return folder.getChildFile("v" + juce::String(decoderVersion)).getChildFile(juce::String(rate));
+}
+
+juce::String IrBank::getCacheName(const SlotSource& source, int slot)
+{
+    return source.pack != nullptr ? "IR_" + juce::String(slot) + ".wav" : source.file.getFileName();
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::readCached(const SlotSource& source, int slot, int rate) const
+{
+   #if BASICEQ_PERSIST_RESAMPLED_IRS
+    juce::File folder;
+    {
+        const juce::ScopedLock sl(lock);
+        folder = cacheFolder;
+    }
+
+    const auto cached = getRateFolder(folder, rate).getChildFile(getCacheName(source, slot));
+    if (folder == juce::File() || !cached.existsAsFile() || cached.getLastModificationTime() < source.file.getLastModificationTime())
+        return nullptr;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(cached.createInputStream().release(), true));
+    if (reader == nullptr || juce::roundToInt(reader->sampleRate) != rate)
+        return nullptr;
+
+    auto ir = std::make_shared<ImpulseResponse>();
+    ir->sampleRate = reader->sampleRate;
+    ir->buffer.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+    reader->read(&ir->buffer, 0, ir->buffer.getNumSamples(), 0, true, true);
+
+    // stored at the level of the file, normalised again here
+    ir->normalisationGain = normalise(ir->buffer);
+    return ir;
+   #else
+    juce::ignoreUnused(source, slot, rate);
+    return nullptr;
+   #endif
+}
+
+void IrBank::writeCached(const SlotSource& source, int slot, const ImpulseResponse& ir, int rate) const
+{
+   #if BASICEQ_PERSIST_RESAMPLED_IRS
+    juce::File folder;
+    {
+        const juce::ScopedLock sl(lock);
+        folder = cacheFolder;
+    }
+
+    if (folder == juce::File())
+        return;
+
+    const auto rateFolder = getRateFolder(folder, rate);
+    if (!rateFolder.createDirectory())
+        return; // not writable, the IRs just stay in memory
+
+    // other instances and hosts write the same file, and readCached() takes anything newer than the source.
+    // So it only ever appears complete: written next to it, then moved over it
+    juce::TemporaryFile temp(rateFolder.getChildFile(getCacheName(source, slot)));
+
+    {
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(temp.getFile().createOutputStream().release(), ir.sampleRate,
+                                                                            (unsigned int)ir.buffer.getNumChannels(), 32, {}, 0));
+        if (writer == nullptr)
+            return;
+
+        juce::AudioBuffer<float> fileLevel(ir.buffer);
+        fileLevel.applyGain(1.f / ir.normalisationGain);
+        if (!writer->writeFromAudioSampleBuffer(fileLevel, 0, fileLevel.getNumSamples()))
+            return;
+    }
+
+    temp.overwriteTargetFileWithTemporary();
+   #else
+    juce::ignoreUnused(source, slot, ir, rate);
+   #endif
+}
+
+float IrBank::normalise(juce::AudioBuffer<float>& buffer)
+{
+    // same as juce::dsp::Convolution::Normalise::yes
+    float maxSumSquared = 0.f;
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const auto* data = buffer.getReadPointer(ch);
+        float sumSquared = 0.f;
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            sumSquared += data[i] * data[i];
+
+        maxSumSquared = juce::jmax(maxSumSquared, sumSquared);
+    }
+
+    if (maxSumSquared <= 0.f)
+        return 1.f;
+
+    const auto gain = juce::Decibels::decibelsToGain(-18.f) / std::sqrt(maxSumSquared);
+    buffer.applyGain(gain);
+    return gain;
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::truncateTail(const std::shared_ptr<const ImpulseResponse>& ir, float residualDecibels)
+{
+    if (ir == nullptr)
+        return nullptr;
+
+    const auto& buffer = ir->buffer;
+    const auto numSamples = buffer.getNumSamples();
+
+    // energy decay curve (Schroeder integral), summed in double so the tail doesn't drown in rounding
+    std::vector<double> remaining((size_t)numSamples + 1, 0.0);
+    for (int i = numSamples - 1; i >= 0; --i)
+    {
+        double energy = 0.0;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            energy += (double)buffer.getSample(ch, i) * buffer.getSample(ch, i);
+
+        remaining[(size_t)i] = remaining[(size_t)i + 1] + energy;
+    }
+
+    const auto limit = remaining[0] * std::pow(10.0, residualDecibels / 10.0);
+    int length = numSamples;
+    while (length > 1 && remaining[(size_t)length - 1] < limit)
+        --length;
+
+    if (length >= numSamples)
+        return ir;
+
+    auto truncated = std::make_shared<ImpulseResponse>();
+    truncated->sampleRate = ir->sampleRate;
+    truncated->normalisationGain = ir->normalisationGain; // the energy that was cut is below the threshold, not worth normalising again
+    truncated->buffer.setSize(buffer.getNumChannels(), length);
+
+    // half cosine fade over the last 2 ms, so the cut doesn't click at the end of every reverb tail
+    const auto fadeLength = juce::jlimit(1, length, juce::roundToInt(0.002 * ir->sampleRate));
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        truncated->buffer.copyFrom(ch, 0, buffer, ch, 0, length);
+
+        auto* data = truncated->buffer.getWritePointer(ch);
+        for (int i = 0; i < fadeLength; ++i)
+            data[length - fadeLength + i] *= 0.5f * (1.f + std::cos(juce::MathConstants<float>::pi * (float)(i + 1) / (float)fadeLength));
+    }
+
+    return truncated;
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::decode(const juce::File& file, int* onset)
+{
+    if (!file.existsAsFile())
+        return nullptr;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+        return nullptr;
+
+    auto ir = std::make_shared<ImpulseResponse>();
+    ir->sampleRate = reader->sampleRate;
+
+    const auto numChannels = juce::jlimit(1, 2, (int)reader->numChannels);
+    juce::AudioBuffer<float> raw(numChannels, (int)reader->lengthInSamples);
+    reader->read(&raw, 0, raw.getNumSamples(), 0, true, numChannels > 1);
+
+    // trim leading and trailing silence, same threshold as juce::dsp::Convolution::Trim::yes
+    const auto threshold = juce::Decibels::decibelsToGain(-80.f);
+    int first = raw.getNumSamples(), last = -1;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* data = raw.getReadPointer(ch);
+        for (int i = 0; i < raw.getNumSamples(); ++i)
+        {
+            if (std::abs(data[i]) > threshold)
+            {
+                first = juce::jmin(first, i);
+                last = juce::jmax(last, i);
+            }
+        }
+    }
+
+    if (last < first)
+        return nullptr; // nothing but silence
+
+    if (onset != nullptr)
+        *onset = first;
+
+    ir->buffer.setSize(numChannels, last - first + 1);
+    for (int ch = 0; ch < numChannels; ++ch)
+        ir->buffer.copyFrom(ch, 0, raw, ch, first, ir->buffer.getNumSamples());
+
+    ir->normalisationGain = normalise(ir->buffer);
+    return ir;
+}
+
+std::shared_ptr<const IrBank::ResampleKernel> IrBank::getResampleKernel(double ratio)
+{
+    // every IR of a session is resampled by the same ratio, the table is made once for it
+    static juce::CriticalSection cacheLock;
+    static std::map<double, std::shared_ptr<const ResampleKernel>> cache;
+
+    const juce::ScopedLock sl(cacheLock);
+    auto& cached = cache[ratio];
+    if (cached != nullptr)
+        return cached;
+
+    auto besselI0 = [](double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50 && term > 1.0e-12 * sum; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    // low pass just below the lower of the two Nyquist frequencies, relative to the input rate.
+    // going down, the kernel gets wider by the same factor so it keeps 32 zero crossings per side
+    const auto bandwidth = 0.95 * juce::jmin(1.0, ratio);
+    constexpr double beta = 9.0;
+
+    auto kernel = std::make_shared<ResampleKernel>();
+    kernel->halfWidth = 32.0 / juce::jmin(1.0, ratio);
+
+    const auto i0Beta = besselI0(beta);
+    const auto numPoints = (int)std::ceil(kernel->halfWidth * ResampleKernel::oversampling) + 2;
+    kernel->table.resize((size_t)numPoints);
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const auto distance = (double)i / ResampleKernel::oversampling;
+        const auto r = distance / kernel->halfWidth;
+        if (r >= 1.0)
+            break;
+
+        const auto x = juce::MathConstants<double>::pi * bandwidth * distance;
+        const auto sinc = distance == 0.0 ? 1.0 : std::sin(x) / x;
+        kernel->table[(size_t)i] = (float)(bandwidth * sinc * besselI0(beta * std::sqrt(1.0 - r * r)) / i0Beta);
+    }
+
+    cached = kernel;
+    return cached;
+}
+
+std::shared_ptr<const ImpulseResponse> IrBank::resample(const ImpulseResponse& ir, double newSampleRate)
+{
+    if (newSampleRate <= 0 || ir.sampleRate <= 0 || juce::roundToInt(newSampleRate) == juce::roundToInt(ir.sampleRate))
+        return std::make_shared<ImpulseResponse>(ir);
+
+    const auto ratio = newSampleRate / ir.sampleRate;
+    const auto numIn = ir.buffer.getNumSamples();
+    const auto numOut = juce::jmax(1, (int)std::ceil(numIn * ratio));
+
+    const auto kernel = getResampleKernel(ratio);
+    const auto halfWidth = kernel->halfWidth;
+
+    auto out = std::make_shared<ImpulseResponse>();
+    out->sampleRate = newSampleRate;
+    out->buffer.setSize(ir.buffer.getNumChannels(), numOut);
+
+    for (int ch = 0; ch < ir.buffer.getNumChannels(); ++ch)
+    {
+        const auto* in = ir.buffer.getReadPointer(ch);
+        auto* dest = out->buffer.getWritePointer(ch);
+
+        for (int m = 0; m < numOut; ++m)
+        {
+            const auto t = m / ratio; // position of the output sample on the input time axis
+            const auto first = juce::jmax(0, (int)std::ceil(t - halfWidth));
+            const auto last = juce::jmin(numIn - 1, (int)std::floor(t + halfWidth));
+
+            double sum = 0;
+            for (int n = first; n <= last; ++n)
+                sum += in[n] * kernel->at(t - n);
+
+            dest[m] = (float)sum;
+        }
+    }
+
+    // the input was normalised already, keep track of the total gain against the file
+    out->normalisationGain = ir.normalisationGain * normalise(out->buffer);
+    return out;
+}
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    IrBank.h
+    Created: 16 Oct 2026 1:18:32pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IrCatalogue.h"
+
+// writes IRs resampled to the session rate next to the Data folder and reads them back on the next start
+#ifndef BASICEQ_PERSIST_RESAMPLED_IRS
+ #define BASICEQ_PERSIST_RESAMPLED_IRS 1
+#endif
+
+// samples of the IR pack the bank writes: 0 float32, 1 half floats (half the size, about 66 dB below each sample)
+#ifndef BASICEQ_IR_PACK_HALF
+ #define BASICEQ_IR_PACK_HALF 0
+#endif
+
+// a decoded impulse response, trimmed of leading/trailing silence and normalised
+// the same way juce::dsp::Convolution would do it
+struct ImpulseResponse
+{
+    juce::AudioBuffer<float> buffer;
+    double sampleRate = 0;
+    float normalisationGain = 1.f;  // already applied to buffer, divide by it to get the level of the file
+};
+
+/**
+ keeps every shipped IR decoded in memory, so changing combo/mic/position never touches the disk.
+ There is one per process (hold it with a juce::SharedResourcePointer), every plugin instance gets
+ its IRs from the same bank, so memory and decoding don't grow with the number of instances.
+ prepare() has a background thread decode all of them and resample them to the session sample
+ rate, so the convolution never has to resample. Every rate that was asked for stays cached.
+ IRs come out of the catalogue's IrPack where it has them, otherwise from their WAV files. Once every
+ IR was decoded from a WAV, they are written to the catalogue's pack file for the next start, unless
+ a pack made from the same WAVs is there already.
+ get() hands out the IR at the given rate (and builds it right away if the background thread
+ has not got to it yet). Both can be called from any thread except the audio thread.
+ IRs that are not in the table (files the user loads) are resampled by the same thread, ahead of the
+ shipped ones, and handed back asynchronously.
+ */
+class IrBank : private juce::Thread
+{
+public:
+    IrBank();
+    ~IrBank() override;
+
+    // bump whenever decode() comes up with different samples (trim, normalisation, ...). Packs and
+    // resampled IRs made by another version are ignored then
+    static constexpr juce::uint32 decoderVersion = 1;
+
+    // called by every instance, the table is the catalogue's and so the same for all of them. IRs that
+    // were decoded already stay, unless the table has something else in their slot. sampleRate is added
+    // to the rates the background thread builds every IR for. Resampled IRs go to the table's cache folder/v<decoderVersion>/<rate>/ and are read from there when newer than their source
+    void prepare(const IrCatalogue::Table& table, double sampleRate);
+    // the IR at sampleRate, at the rate of its file for 0
+    std::shared_ptr<const ImpulseResponse> get(int comboType, int mikType, int yPos, int xPos, double sampleRate);
+
+    // owner.triggerAsyncUpdate() is called once takeResampled() has ir at sampleRate. A newer request
+    // of the same owner replaces the one before, after cancelResample() owner is never triggered again
+    void requestResample(juce::AsyncUpdater& owner, std::shared_ptr<const ImpulseResponse> ir, double sampleRate);
+    std::shared_ptr<const ImpulseResponse> takeResampled(juce::AsyncUpdater& owner);
+    void cancelResample(juce::AsyncUpdater& owner);
+
+    // reads, trims and normalises a single file, nullptr if it can't be read. onset gets the samples trimmed off the front
+    static std::shared_ptr<const ImpulseResponse> decode(const juce::File& file, int* onset = nullptr);
+
+    // band-limited (Kaiser windowed sinc) resampling, the result is normalised again
+    static std::shared_ptr<const ImpulseResponse> resample(const ImpulseResponse& ir, double newSampleRate);
+
+    // same as juce::dsp::Convolution::Normalise::yes, returns the gain that was applied
+    static float normalise(juce::AudioBuffer<float>& buffer);
+
+    // cuts the tail where the energy still to come (backwards integrated, over all channels) drops
+    // below residualDecibels of the total and fades out the last 2 ms. Returns ir itself if nothing is cut
+    static std::shared_ptr<const ImpulseResponse> truncateTail(const std::shared_ptr<const ImpulseResponse>& ir, float residualDecibels);
+private:
+    static constexpr int numSlots = IrCatalogue::numSlots;
+
+    using SlotArray = std::array<std::shared_ptr<const ImpulseResponse>, numSlots>;
+
+    // where the IR of a slot comes from
+    struct SlotSource
+    {
+        juce::File file;                       // the WAV, or the pack file
+        std::shared_ptr<const IrPack> pack;
+        int packIndex = -1;
+
+        bool exists() const { return pack != nullptr || file.existsAsFile(); }
+        bool operator== (const SlotSource& other) const { return file == other.file && pack == other.pack && packIndex == other.packIndex; }
+        bool operator!= (const SlotSource& other) const { return !(*this == other); }
+    };
+
+    // a requestResample(), result stays nullptr until it is done
+    struct ResampleJob
+    {
+        std::shared_ptr<const ImpulseResponse> source, result;
+        double sampleRate = 0;
+    };
+
+    // Kaiser windowed sinc over one side, oversampling points per input sample and read with
+    // linear interpolation (under -100 dB off the exact one). Evaluating the window, a Bessel series,
+    // for every tap of every output sample was nearly all the time resample() took
+    struct ResampleKernel
+    {
+        static constexpr int oversampling = 512;
+        double halfWidth = 0;   // in input samples
+        std::vector<float> table;
+
+        float at(double distance) const
+        {
+            const auto position = std::abs(distance) * oversampling;
+            const auto index = (size_t)position;
+            if (index + 1 >= table.size())
+                return 0.f;
+
+            const auto fraction = (float)(position - (double)index);
+            return table[index] + fraction * (table[index + 1] - table[index]);
+        }
+    };
+
+    static std::shared_ptr<const ResampleKernel> getResampleKernel(double ratio);
+    std::shared_ptr<const ImpulseResponse> build(int slot, int rate);
+    void runResampleJobs();
+    // resampled IRs are cached under the name of the WAV, or of the slot for IRs from a pack
+    static juce::File getRateFolder(const juce::File& folder, int rate);
+    static juce::String getCacheName(const SlotSource& source, int slot);
+    std::shared_ptr<const ImpulseResponse> readCached(const SlotSource& source, int slot, int rate) const;
+    void writeCached(const SlotSource& source, int slot, const ImpulseResponse& ir, int rate) const;
+    void writePack();
+    void run() override;
+
+    juce::CriticalSection lock;
+    std::array<SlotSource, numSlots> sources;
+    std::array<int, numSlots> onsets{};
+    SlotArray originals;
+    std::map<int, SlotArray> resampled;   // keyed by sample rate in Hz
+    std::vector<int> rates;               // every rate prepare() was called with
+    std::map<juce::AsyncUpdater*, ResampleJob> resampleJobs;
+    juce::File cacheFolder, packFile;
+    IrCatalogue::Fingerprint packSources;   // what a pack written now would be made from
+};
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    IrBlender.cpp
+    Created: 16 Oct 2026 3:12:09pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "IrBlender.h"
+
+namespace
+{
+    // measured positions, x files are named after the distance in cm
+    const float xStepCm = 2.f, maxXCm = 8.f;
+    const std::array<float, 3> yGridCm{ { 0.f, 10.f, 40.f } };
+}
+
+IrBlender::IrBlender(IrBank& irBank, juce::AsyncUpdater& updater) : juce::Thread("IR blender"), bank(irBank), onBlendReady(updater)
+{
+    startThread();
+}
+
+IrBlender::~IrBlender()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(5000);
+}
+
+void IrBlender::request(const Position& position)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pending = position;
+        hasPending = true;
+    }
+
+    notify();
+}
+
+std::shared_ptr<const ImpulseResponse> IrBlender::takeResult()
+{
+    const juce::ScopedLock sl(lock);
+    return std::move(result);
+}
+
+void IrBlender::invalidate()
+{
+    const juce::ScopedLock sl(lock);
+    hasBlended = false;
+}
+
+void IrBlender::run()
+{
+    while (!threadShouldExit())
+    {
+        Position position;
+        bool hasWork;
+        {
+            // requests that came in while the last blend was running collapse into the newest one
+            const juce::ScopedLock sl(lock);
+            position = pending;
+            hasWork = hasPending && !(hasBlended && position == lastBlended);
+            hasPending = false;
+        }
+
+        if (!hasWork)
+        {
+            wait(-1);
+            continue;
+        }
+
+        auto blended = blend(position);
+        if (blended == nullptr)
+            continue;
+
+        {
+            const juce::ScopedLock sl(lock);
+            result = std::move(blended);
+            lastBlended = position;
+            hasBlended = true;
+        }
+
+        onBlendReady.triggerAsyncUpdate();
+    }
+}
+
+std::shared_ptr<const ImpulseResponse> IrBlender::blend(const Position& position)
+{
+    // neighbours and weights along each axis
+    const auto x = juce::jlimit(0.f, maxXCm, position.xCm);
+    const auto x0 = juce::jmin((int)(x / xStepCm), (int)(maxXCm / xStepCm) - 1);
+    const auto fx = x / xStepCm - (float)x0;
+
+    const auto y = juce::jlimit(yGridCm.front(), yGridCm.back(), position.yCm);
+    const auto y0 = y < yGridCm[1] ? 0 : 1;
+    const auto fy = (y - yGridCm[(size_t)y0]) / (yGridCm[(size_t)y0 + 1] - yGridCm[(size_t)y0]);
+
+    struct Corner
+    {
+        std::shared_ptr<const ImpulseResponse> ir;
+        float weight;
+        int onset = 0;
+    };
+
+    std::vector<Corner> corners;
+    float totalWeight = 0.f;
+
+    for (int dy = 0; dy < 2; ++dy)
+        for (int dx = 0; dx < 2; ++dx)
+        {
+            const auto weight = (dx == 0 ? 1.f - fx : fx) * (dy == 0 ? 1.f - fy : fy);
+            if (weight < 1.0e-4f)
+                continue;
+
+            // x index in the bank is the distance in cm
+            if (auto ir = bank.get(position.comboType, position.mikType, y0 + dy, (int)((x0 + dx) * xStepCm), position.sampleRate))
+            {
+                corners.push_back({ std::move(ir), weight });
+                totalWeight += weight;
+            }
+        }
+
+    if (corners.empty())
+        return nullptr;
+
+    // right on a measured position, nothing to blend
+    if (corners.size() == 1)
+        return corners.front().ir;
+
+    // onset: first sample within 20 dB of the peak
+    float onsetTime = 0.f;
+    int numChannels = 0, tail = 0;
+    for (auto& corner : corners)
+    {
+        const auto& buffer = corner.ir->buffer;
+        const auto threshold = 0.1f * buffer.getMagnitude(0, buffer.getNumSamples());
+
+        corner.onset = buffer.getNumSamples();
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            const auto* data = buffer.getReadPointer(ch);
+            for (int i = 0; i < corner.onset; ++i)
+            {
+                if (std::abs(data[i]) >= threshold)
+                {
+                    corner.onset = i;
+                    break;
+                }
+            }
+        }
+
+        corner.weight /= totalWeight;
+        onsetTime += corner.weight * (float)corner.onset;
+        numChannels = juce::jmax(numChannels, buffer.getNumChannels());
+        tail = juce::jmax(tail, buffer.getNumSamples() - corner.onset);
+    }
+
+    const auto onset = juce::roundToInt(onsetTime);
+
+    auto out = std::make_shared<ImpulseResponse>();
+    out->sampleRate = corners.front().ir->sampleRate;
+    out->buffer.setSize(numChannels, onset + tail);
+    out->buffer.clear();
+
+    // blended at the level of the files, so it gets normalised like any other IR
+    for (const auto& corner : corners)
+    {
+        const auto& buffer = corner.ir->buffer;
+        const auto shift = onset - corner.onset;
+        const auto first = juce::jmax(0, -shift);
+        const auto gain = corner.weight / corner.ir->normalisationGain;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            out->buffer.addFrom(ch, first + shift, buffer, juce::jmin(ch, buffer.getNumChannels() - 1), first,
+                                buffer.getNumSamples() - first, gain);
+    }
+
+    out->normalisationGain = IrBank::normalise(out->buffer);
+    return out;
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    IrBlender.h
+    Created: 16 Oct 2026 3:12:09pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IrBank.h"
+
+/**
+ builds the IR for a mic position in between the measured ones.
+ The four neighbouring IRs of the grid are blended bilinearly, each one shifted first so its onset
+ lands on the blended onset time - without that the different arrival times comb filter.
+ Runs on its own thread, only the newest request is worked on, the convolution then gets the
+ result like any other IR (crossfaded), so moving the mic never costs more than one convolution.
+ */
+class IrBlender : private juce::Thread
+{
+public:
+    struct Position
+    {
+        int comboType = 0, mikType = 0;
+        float xCm = 0.f, yCm = 0.f;
+        double sampleRate = 0.0;   // the rate the corner IRs are taken from the bank at
+
+        bool operator==(const Position& other) const
+        {
+            return comboType == other.comboType && mikType == other.mikType && xCm == other.xCm && yCm == other.yCm
+                && sampleRate == other.sampleRate;
+        }
+    };
+
+    // onBlendReady is triggered (from the blender thread) when takeResult() has something new
+    IrBlender(IrBank& bank, juce::AsyncUpdater& onBlendReady);
+    ~IrBlender() override;
+
+    void request(const Position& position);
+    std::shared_ptr<const ImpulseResponse> takeResult();
+
+    // forget the last blend, e.g. after the sample rate changed
+    void invalidate();
+private:
+    void run() override;
+    std::shared_ptr<const ImpulseResponse> blend(const Position& position);
+
+    IrBank& bank;
+    juce::AsyncUpdater& onBlendReady;
+    juce::CriticalSection lock;
+    Position pending, lastBlended;
+    bool hasPending = false, hasBlended = false;
+    std::shared_ptr<const ImpulseResponse> result;
+};
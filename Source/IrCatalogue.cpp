@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    IrCatalogue.cpp
+    Created: 16 Oct 2026 9:47:05pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "IrCatalogue.h"
+#include "IrPack.h"
+
+IrCatalogue::IrCatalogue() : juce::Thread("IR catalogue"), table(open())
+{
+    // whether the WAVs are still what the pack was written from is checked off the startup path
+    rescanRequested = table->pack != nullptr;
+    startThread();
+}
+
+IrCatalogue::~IrCatalogue()
+{
+    stopThread(5000);
+}
+
+int IrCatalogue::getSlot(int combo, int mic, int distance, int position)
+{
+    if (!juce::isPositiveAndBelow(combo, numCombos) || !juce::isPositiveAndBelow(mic, numMics)
+        || !juce::isPositiveAndBelow(distance, numDistances) || !juce::isPositiveAndBelow(position, numPositions))
+        return -1;
+
+    return ((combo * numMics + mic) * numDistances + distance) * numPositions + position;
+}
+
+IrCatalogue::Position IrCatalogue::getPosition(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, numSlots));
+    return { slot / (numMics * numDistances * numPositions), slot / (numDistances * numPositions) % numMics,
+             slot / numPositions % numDistances, slot % numPositions };
+}
+
+std::shared_ptr<const IrCatalogue::Table> IrCatalogue::getTable() const
+{
+    const juce::ScopedLock sl(lock);
+    return table;
+}
+
+void IrCatalogue::rescan()
+{
+    rescanRequested = true;
+    notify();
+}
+
+void IrCatalogue::run()
+{
+    while (!threadShouldExit())
+    {
+        if (!rescanRequested.exchange(false))
+        {
+            wait(-1);
+            continue;
+        }
+
+        // instances keep getting the old table meanwhile. Nothing changes for them unless the WAVs did,
+        // a pack the bank wrote since is what they have decoded already
+        auto newTable = scan();
+        if (newTable->sources == getTable()->sources)
+            continue;
+
+        {
+            const juce::ScopedLock sl(lock);
+            table = std::move(newTable);
+        }
+
+        sendChangeMessage();
+    }
+}
+
+juce::File IrCatalogue::getRoot()
+{
+    return juce::File::getSpecialLocation(juce::File::commonApplicationDataDirectory).getChildFile("PechacekIRLoader");
+}
+
+IrCatalogue::Fingerprint IrCatalogue::getSources(std::array<juce::File, numSlots>& files)
+{
+    Fingerprint sources;
+    sources.decoderVersion = IrBank::decoderVersion;
+
+    // Files are named <mic>_<distance>_<combo>_<x>: mic 57A, kalib or the third one,
+    // distance 0cm, 10cm or 40cm, combo Mar, MM or the third one
+    for (const auto& entry : juce::RangedDirectoryIterator(getRoot().getChildFile("Data"), true, "*.wav", juce::File::findFiles))
+    {
+        ++sources.numFiles;
+        sources.newestModification = juce::jmax(sources.newestModification, entry.getModificationTime().toMilliseconds());
+        sources.totalBytes += entry.getFileSize();
+
+        juce::StringArray tokens;
+        tokens.addTokens(entry.getFile().getFileNameWithoutExtension(), "_", "\"");
+
+        const auto mic = tokens[0] == "57A" ? 0 : tokens[0] == "kalib" ? 1 : 2;
+        const auto distance = tokens[1] == "0cm" ? 0 : tokens[1] == "10cm" ? 1 : 2;
+        const auto combo = tokens[2] == "Mar" ? 0 : tokens[2] == "MM" ? 1 : 2;
+
+        const auto slot = getSlot(combo, mic, distance, tokens[3].getIntValue());
+        if (slot >= 0)
+            files[(size_t)slot] = entry.getFile();
+    }
+
+    return sources;
+}
+
+std::shared_ptr<const IrCatalogue::Table> IrCatalogue::open()
+{
+    const auto root = getRoot();
+
+    // one memory mapped file with every IR, only its header and index are read here
+    auto pack = IrPack::open(root.getChildFile("IRs.irpack"));
+    if (pack == nullptr || pack->getSources().decoderVersion != IrBank::decoderVersion)
+        return scan();
+
+    auto newTable = std::make_shared<Table>();
+    newTable->packFile = pack->getFile();
+    newTable->cacheFolder = root.getChildFile("Cache");
+    newTable->sources = pack->getSources();
+    newTable->pack = std::move(pack);
+    return newTable;
+}
+
+std::shared_ptr<const IrCatalogue::Table> IrCatalogue::scan()
+{
+    const auto root = getRoot();
+
+    auto newTable = std::make_shared<Table>();
+    newTable->packFile = root.getChildFile("IRs.irpack");
+    newTable->cacheFolder = root.getChildFile("Cache");
+
+    // walked with a pack too, to tell whether the pack is still what the WAVs decode to
+    newTable->sources = getSources(newTable->files);
+
+    // an installer may ship the pack without the WAVs, then it is all there is and as up to date as it gets
+    auto pack = IrPack::open(newTable->packFile);
+    if (pack != nullptr && newTable->sources.numFiles == 0)
+        newTable->sources = pack->getSources();
+
+    if (pack != nullptr && pack->getSources() == newTable->sources)
+        newTable->pack = std::move(pack);
+
+    return newTable;
+}
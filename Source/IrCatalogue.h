@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    IrCatalogue.h
+    Created: 16 Oct 2026 9:47:05pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class IrPack;
+
+/**
+ where the shipped IRs are: the IR pack if it was made from the WAVs that are in the Data folder now,
+ otherwise a WAV per slot. On startup a pack is taken on the fingerprint it was written with and the
+ Data folder is only listed afterwards, on the background thread, to check it is still up to date.
+ Built once per process and shared by every plugin instance (hold it with juce::SharedResourcePointer),
+ so neither creating an instance nor prepareToPlay() touches the disk. rescan() (the editor calls it when
+ it opens) has a background thread look at the Data folder again. Only when the WAVs are not what the table
+ was made from is there a new table, a pack written from the old ones is dropped then, and listeners get
+ a change message (on the message thread).
+ Slots are flat, combo major: ((combo * numMics + mic) * numDistances + distance) * numPositions + position.
+ Thread safe, tables are never changed once handed out.
+ */
+class IrCatalogue : public juce::ChangeBroadcaster,
+                    private juce::Thread
+{
+public:
+    static constexpr int numCombos = 3, numMics = 3, numDistances = 3, numPositions = 12;
+    static constexpr int numSlots = numCombos * numMics * numDistances * numPositions;
+
+    // what a slot is, the IR pack is indexed by the same
+    struct Position
+    {
+        int combo = 0, mic = 0, distance = 0, position = 0;
+    };
+
+    // -1 if any of them is out of range
+    static int getSlot(int combo, int mic, int distance, int position);
+    static Position getPosition(int slot);
+
+    // what a set of decoded IRs was made from, the IR pack stores the one it was written from
+    struct Fingerprint
+    {
+        juce::uint32 decoderVersion = 0;   // IrBank::decoderVersion
+        int numFiles = 0;                  // WAVs in the Data folder
+        juce::int64 newestModification = 0, totalBytes = 0;
+
+        bool operator== (const Fingerprint& other) const
+        {
+            return decoderVersion == other.decoderVersion && numFiles == other.numFiles
+                && newestModification == other.newestModification && totalBytes == other.totalBytes;
+        }
+        bool operator!= (const Fingerprint& other) const { return !(*this == other); }
+    };
+
+    struct Table
+    {
+        std::array<juce::File, numSlots> files;   // File() where no WAV was found, or it wasn't looked for (pack taken on startup)
+        Fingerprint sources;                      // of the WAVs, or what the pack says they were
+        std::shared_ptr<const IrPack> pack;       // nullptr if there is none or it is out of date
+        juce::File packFile;                      // where the pack is or goes
+        juce::File cacheFolder;                   // for IRs resampled to other rates
+    };
+
+    IrCatalogue();
+    ~IrCatalogue() override;
+
+    std::shared_ptr<const Table> getTable() const;
+    // any thread, returns right away. Requests that come in while a scan runs are served by one more scan
+    void rescan();
+private:
+    static juce::File getRoot();
+    // walks the Data folder, files gets the WAV of every slot that has one
+    static Fingerprint getSources(std::array<juce::File, numSlots>& files);
+    // the pack as it is if there is one for this decoder, otherwise scan()
+    static std::shared_ptr<const Table> open();
+    static std::shared_ptr<const Table> scan();
+    void run() override;
+
+    std::atomic<bool> rescanRequested{ false };
+
+    mutable juce::CriticalSection lock;
+    std::shared_ptr<const Table> table;
+};
@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+    IrPack.cpp
+    Created: 16 Oct 2026 9:02:17pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "IrPack.h"
+
+namespace
+{
+    float readFloat(const char* bytes)
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt(bytes);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    float halfToFloat(juce::uint16 half)
+    {
+        const auto sign = (half & 0x8000) != 0 ? -1.f : 1.f;
+        const auto exponent = (half >> 10) & 0x1f;
+        const auto mantissa = half & 0x3ff;
+
+        if (exponent == 0)
+            return sign * std::ldexp((float)mantissa, -24);   // subnormal
+        if (exponent == 31)
+            return mantissa == 0 ? sign * std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+
+        return sign * std::ldexp((float)(mantissa | 0x400), exponent - 25);
+    }
+
+    // rounds to nearest, ties away from zero
+    juce::uint16 floatToHalf(float value)
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const auto sign = (juce::uint16)((bits >> 16) & 0x8000);
+        const auto exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+        auto mantissa = bits & 0x7fffff;
+
+        if ((bits & 0x7fffffff) > 0x7f800000)
+            return (juce::uint16)(sign | 0x7e00);
+        if (exponent >= 31)
+            return (juce::uint16)(sign | 0x7c00);
+
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+                return sign;
+
+            mantissa |= 0x800000;
+            const auto shift = 14 - exponent;
+            return (juce::uint16)(sign | ((mantissa >> shift) + ((mantissa >> (shift - 1)) & 1)));
+        }
+
+        // a carry out of the mantissa rounds up into the exponent, which is what it should do
+        return (juce::uint16)(sign | (((juce::uint32)exponent << 10 | mantissa >> 13) + ((mantissa >> 12) & 1)));
+    }
+
+    juce::uint64 align16(juce::uint64 offset)
+    {
+        return (offset + 15) & ~(juce::uint64)15;
+    }
+}
+
+std::unique_ptr<IrPack> IrPack::open(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return nullptr;
+
+    std::unique_ptr<IrPack> pack(new IrPack());
+    pack->file = file;
+    pack->mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+    const auto* data = static_cast<const char*>(pack->mapping->getData());
+    const auto size = (juce::uint64)pack->mapping->getSize();
+
+    if (data == nullptr || size < (juce::uint64)headerSize || std::memcmp(data, "IRPK", 4) != 0
+        || juce::ByteOrder::littleEndianInt(data + 4) != version)
+        return nullptr;
+
+    const auto numEntries = juce::ByteOrder::littleEndianInt(data + 8);
+    pack->sources.decoderVersion = juce::ByteOrder::littleEndianInt(data + 12);
+    pack->sources.numFiles = (int)juce::ByteOrder::littleEndianInt(data + 16);
+    pack->sources.newestModification = (juce::int64)juce::ByteOrder::littleEndianInt64(data + 24);
+    pack->sources.totalBytes = (juce::int64)juce::ByteOrder::littleEndianInt64(data + 32);
+
+    if ((juce::uint64)headerSize + (juce::uint64)numEntries * entrySize > size)
+        return nullptr;
+
+    pack->entries.reserve(numEntries);
+    pack->offsets.reserve(numEntries);
+
+    for (juce::uint32 i = 0; i < numEntries; ++i)
+    {
+        const auto* entry = data + headerSize + (size_t)i * entrySize;
+        const auto* bytes = reinterpret_cast<const juce::uint8*>(entry);
+
+        Info info;
+        info.key = { bytes[0], bytes[1], bytes[2], bytes[3] };
+        info.format = (SampleFormat)bytes[4];
+        info.numChannels = bytes[5];
+        info.length = (int)juce::ByteOrder::littleEndianInt(entry + 8);
+        info.onset = (int)juce::ByteOrder::littleEndianInt(entry + 12);
+        info.sampleRate = readFloat(entry + 16);
+        info.peak = readFloat(entry + 20);
+        info.normalisationGain = readFloat(entry + 24);
+        const auto offset = (juce::uint64)juce::ByteOrder::littleEndianInt64(entry + 32);
+
+        const auto bytesPerSample = info.format == Format_Half ? 2 : 4;
+        const auto dataSize = (juce::uint64)info.numChannels * (juce::uint64)(juce::uint32)info.length * (juce::uint64)bytesPerSample;
+
+        if (bytes[4] > Format_Half || !juce::isPositiveAndNotGreaterThan(info.numChannels, 2) || info.length <= 0
+            || info.sampleRate <= 0 || offset % 4 != 0 || offset + dataSize > size)
+            return nullptr;
+
+        pack->entries.push_back(info);
+        pack->offsets.push_back(offset);
+    }
+
+    return pack;
+}
+
+int IrPack::find(const Key& key) const
+{
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const auto& k = entries[i].key;
+        if (k.combo == key.combo && k.mic == key.mic && k.distance == key.distance && k.position == key.position)
+            return (int)i;
+    }
+
+    return -1;
+}
+
+std::shared_ptr<const ImpulseResponse> IrPack::read(int index) const
+{
+    if (!juce::isPositiveAndBelow(index, getNumEntries()))
+        return nullptr;
+
+    const auto& info = entries[(size_t)index];
+    const auto* samples = static_cast<const char*>(mapping->getData()) + offsets[(size_t)index];
+
+    auto ir = std::make_shared<ImpulseResponse>();
+    ir->sampleRate = info.sampleRate;
+    ir->normalisationGain = info.normalisationGain;
+    ir->buffer.setSize(info.numChannels, info.length);
+
+    for (int ch = 0; ch < info.numChannels; ++ch)
+    {
+        auto* dest = ir->buffer.getWritePointer(ch);
+
+        if (info.format == Format_Half)
+        {
+            const auto* source = samples + (size_t)ch * (size_t)info.length * 2;
+            for (int i = 0; i < info.length; ++i)
+                dest[i] = halfToFloat(juce::ByteOrder::littleEndianShort(source + 2 * i));
+        }
+        else
+        {
+            const auto* source = samples + (size_t)ch * (size_t)info.length * 4;
+            for (int i = 0; i < info.length; ++i)
+                dest[i] = readFloat(source + 4 * i);
+        }
+    }
+
+    return ir;
+}
+
+bool IrPack::write(const juce::File& target, const std::vector<Source>& irs, SampleFormat format, const IrCatalogue::Fingerprint& fingerprint)
+{
+    std::vector<const Source*> sources;
+    for (const auto& source : irs)
+        if (source.ir != nullptr && source.ir->buffer.getNumSamples() > 0)
+            sources.push_back(&source);
+
+    const auto bytesPerSample = format == Format_Half ? 2 : 4;
+    juce::TemporaryFile temp(target);
+
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        out.write("IRPK", 4);
+        out.writeInt((int)version);
+        out.writeInt((int)sources.size());
+        out.writeInt((int)fingerprint.decoderVersion);
+        out.writeInt(fingerprint.numFiles);
+        out.writeInt(0);
+        out.writeInt64(fingerprint.newestModification);
+        out.writeInt64(fingerprint.totalBytes);
+
+        const auto dataStart = align16((juce::uint64)headerSize + sources.size() * (juce::uint64)entrySize);
+        auto offset = dataStart;
+
+        for (const auto* source : sources)
+        {
+            const auto& buffer = source->ir->buffer;
+            const auto numChannels = juce::jmin(2, buffer.getNumChannels());
+
+            out.writeByte((char)source->key.combo);
+            out.writeByte((char)source->key.mic);
+            out.writeByte((char)source->key.distance);
+            out.writeByte((char)source->key.position);
+            out.writeByte((char)format);
+            out.writeByte((char)numChannels);
+            out.writeShort(0);
+            out.writeInt(buffer.getNumSamples());
+            out.writeInt(source->onset);
+            out.writeFloat((float)source->ir->sampleRate);
+            out.writeFloat(buffer.getMagnitude(0, buffer.getNumSamples()));
+            out.writeFloat(source->ir->normalisationGain);
+            out.writeInt(0);
+            out.writeInt64((juce::int64)offset);
+
+            offset = align16(offset + (juce::uint64)numChannels * (juce::uint64)buffer.getNumSamples() * (juce::uint64)bytesPerSample);
+        }
+
+        out.writeRepeatedByte(0, (size_t)(dataStart - (juce::uint64)out.getPosition()));
+
+        for (const auto* source : sources)
+        {
+            const auto& buffer = source->ir->buffer;
+            const auto numChannels = juce::jmin(2, buffer.getNumChannels());
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto* data = buffer.getReadPointer(ch);
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                {
+                    if (format == Format_Half)
+                        out.writeShort((short)floatToHalf(data[i]));
+                    else
+                        out.writeFloat(data[i]);
+                }
+            }
+
+            out.writeRepeatedByte(0, (size_t)(align16((juce::uint64)out.getPosition()) - (juce::uint64)out.getPosition()));
+        }
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
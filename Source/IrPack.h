@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    IrPack.h
+    Created: 16 Oct 2026 9:02:17pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IrBank.h"
+#include "IrCatalogue.h"
+
+/**
+ every shipped IR in one file, instead of a folder of WAVs to scan and decode.
+ The samples are stored the way IrBank::decode() leaves them (silence trimmed, normalised), as float32
+ or IEEE half floats, so reading one is a copy out of the file. The file is memory mapped: opening it
+ only touches the index, and every instance in a process (with most OSs every process) reads the same pages.
+ It remembers the WAVs it was made from (IrCatalogue::Fingerprint), the catalogue ignores it once they changed.
+ Little endian:
+   header  "IRPK", uint32 version, uint32 number of entries, uint32 decoder version, uint32 number of WAVs,
+           uint32 reserved, int64 newest WAV modification time (ms), int64 total size of the WAVs
+   entry   uint8 combo, mic, distance, position, uint8 sample format, uint8 channels, uint16 reserved,
+           uint32 length, uint32 onset, float sample rate, float peak, float normalisation gain,
+           uint32 reserved, uint64 offset of the samples (16 byte aligned, one channel after the other)
+ */
+class IrPack
+{
+public:
+    enum SampleFormat
+    {
+        Format_Float32,
+        Format_Half
+    };
+
+    using Key = IrCatalogue::Position;
+
+    struct Info
+    {
+        Key key;
+        SampleFormat format = Format_Float32;
+        int numChannels = 1, length = 0;
+        int onset = 0;                   // samples of silence trimmed off the front of the recording
+        double sampleRate = 0;
+        float peak = 0;                  // of the stored, normalised samples
+        float normalisationGain = 1.f;   // as in ImpulseResponse
+    };
+
+    struct Source
+    {
+        Key key;
+        std::shared_ptr<const ImpulseResponse> ir;
+        int onset = 0;
+    };
+
+    // nullptr if the file is missing, not a pack or cut short
+    static std::unique_ptr<IrPack> open(const juce::File& file);
+    // written to a temporary file that replaces the target once complete. False if it couldn't be written
+    static bool write(const juce::File& file, const std::vector<Source>& irs, SampleFormat format, const IrCatalogue::Fingerprint& sources);
+
+    const juce::File& getFile() const { return file; }
+    const IrCatalogue::Fingerprint& getSources() const { return sources; }
+    int getNumEntries() const { return (int)entries.size(); }
+    const Info& getInfo(int index) const { return entries[(size_t)index]; }
+    // -1 if the pack doesn't have it
+    int find(const Key& key) const;
+
+    // copies (and converts) the samples out of the mapping, any thread
+    std::shared_ptr<const ImpulseResponse> read(int index) const;
+private:
+    IrPack() = default;
+
+    static constexpr juce::uint32 version = 2;
+    static constexpr int headerSize = 40, entrySize = 40;
+
+    juce::File file;
+    IrCatalogue::Fingerprint sources;
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    std::vector<Info> entries;
+    std::vector<juce::uint64> offsets;
+};
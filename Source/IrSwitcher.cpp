@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    IrSwitcher.cpp
+    Created: 16 Oct 2026 2:05:48pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "IrSwitcher.h"
+
+IrSwitcher::IrSwitcher()
+{
+    startTimer(100);
+}
+
+IrSwitcher::~IrSwitcher()
+{
+    stopTimer();
+    deleteRetired();
+    delete handoff.exchange(nullptr);
+}
+
+void IrSwitcher::prepare(const juce::dsp::ProcessSpec& newSpec)
+{
+    spec = newSpec;
+    scratch.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+    // timerCallback() is the consumer of retiredFifo. Hosts may call prepareToPlay() from another thread,
+    // then the engines that are in there wait for the next timer tick
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        deleteRetired();
+
+    delete handoff.exchange(nullptr);
+    incoming.reset();
+    fading = false;
+    switching = false;
+    currentIRSize = 0;
+
+    // an IR at another rate isn't resampled here, the owner loads it again at the new one
+    const auto matchesRate = currentIR != nullptr && juce::roundToInt(currentIR->sampleRate) == juce::roundToInt(spec.sampleRate);
+    active = matchesRate ? makeEngine(*currentIR, juce::Time::getHighResolutionTicks(), currentIncludesEq) : nullptr;
+}
+
+std::unique_ptr<IrSwitcher::Engine> IrSwitcher::makeEngine(const ImpulseResponse& ir, juce::int64 loadTicks, bool includesEq)
+{
+    auto engine = std::make_unique<Engine>();
+    engine->loadTicks = loadTicks;
+    engine->includesEq = includesEq;
+
+    // IRs from the bank are at the session rate already, only one that was on its way while
+    // the rate changed is resampled here
+    if (juce::roundToInt(ir.sampleRate) != juce::roundToInt(spec.sampleRate))
+        engine->convolution.prepare(spec, *IrBank::resample(ir, spec.sampleRate));
+    else
+        engine->convolution.prepare(spec, ir);
+
+    return engine;
+}
+
+void IrSwitcher::load(std::shared_ptr<const ImpulseResponse> ir, bool includesEq)
+{
+    currentIR = std::move(ir);
+    currentIncludesEq = includesEq;
+    if (currentIR == nullptr || spec.sampleRate <= 0)
+        return; // prepare() builds the engine
+
+    auto engine = makeEngine(*currentIR, juce::Time::getHighResolutionTicks(), includesEq);
+
+    // the audio thread never saw a stale one, so it can go right here
+    delete handoff.exchange(engine.release());
+    switching = true;
+}
+
+void IrSwitcher::beginBlock()
+{
+    // a switch runs to its end, otherwise continuous automation would never get to hear anything new
+    if (incoming == nullptr && handoff.load() != nullptr)
+        incoming.reset(handoff.exchange(nullptr));
+}
+
+bool IrSwitcher::needsEqInput() const
+{
+    return !activeHasIR() || !active->includesEq || (incoming != nullptr && !incoming->includesEq);
+}
+
+bool IrSwitcher::needsDryInput() const
+{
+    return (activeHasIR() && active->includesEq) || (incoming != nullptr && incoming->includesEq);
+}
+
+void IrSwitcher::processActive(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& dryInput)
+{
+    if (!activeHasIR())
+        return;
+
+    if (active->includesEq)
+        block.copyFrom(dryInput);
+
+    active->convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+}
+
+void IrSwitcher::process(const juce::dsp::ProcessContextReplacing<float>& context, const juce::dsp::AudioBlock<float>& dryInput)
+{
+    const auto& block = context.getOutputBlock();
+    jassert(!needsDryInput() || dryInput.getNumSamples() >= block.getNumSamples());
+
+    if (incoming == nullptr)
+    {
+        processActive(block, dryInput);
+        return;
+    }
+
+    const auto numSamples = block.getNumSamples();
+    const auto chunkSize = (size_t)juce::jmax(1, scratch.getNumSamples());
+
+    // hosts are allowed to go over the prepared block size, scratch only holds that much
+    for (size_t start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto n = juce::jmin(chunkSize, numSamples - start);
+        const auto chunk = block.getSubBlock(start, n);
+        const auto dryChunk = dryInput.getNumSamples() > 0 ? dryInput.getSubBlock(start, n) : dryInput;
+
+        if (incoming != nullptr)
+            processChunk(chunk, dryChunk);
+        else // switch finished in an earlier chunk
+            processActive(chunk, dryChunk);
+    }
+}
+
+void IrSwitcher::processChunk(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& dryInput)
+{
+    const auto numSamples = (int)block.getNumSamples();
+    const auto numChannels = juce::jmin((int)block.getNumChannels(), scratch.getNumChannels());
+
+    auto newOutput = juce::dsp::AudioBlock<float>(scratch).getSubsetChannelBlock(0, (size_t)numChannels).getSubBlock(0, (size_t)numSamples);
+    newOutput.copyFrom(incoming->includesEq ? dryInput : block);
+    incoming->convolution.process(juce::dsp::ProcessContextReplacing<float>(newOutput));
+
+    processActive(block, dryInput);
+
+    if (!fading)
+    {
+        if (!activeHasIR())
+        {
+            // nothing to fade from
+            block.copyFrom(newOutput);
+            if (active == nullptr || canRetire())
+                finishSwitch();
+            return;
+        }
+
+        // the fresh engine starts from silence, it is only in steady state once it has seen a whole IR length of input
+        incoming->samplesProcessed += numSamples;
+        if (incoming->samplesProcessed < incoming->convolution.getCurrentIRSize())
+            return;
+
+        fading = true;
+        fadePosition = 0;
+        fadeLength = juce::jmax(1, juce::roundToInt(crossfadeSeconds.load() * spec.sampleRate));
+        return;
+    }
+
+    // equal power, the two IRs are not correlated enough for a linear fade to keep the level
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto progress = juce::jmin(1.f, (float)(fadePosition + i) / (float)fadeLength);
+        const auto oldGain = std::cos(progress * juce::MathConstants<float>::halfPi);
+        const auto newGain = std::sin(progress * juce::MathConstants<float>::halfPi);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            block.setSample(ch, i, block.getSample(ch, i) * oldGain + newOutput.getSample(ch, i) * newGain);
+    }
+
+    fadePosition += numSamples;
+
+    // if the old engine can't be handed back yet, keep running both at full new gain and try again next time
+    if (fadePosition >= fadeLength && canRetire())
+        finishSwitch();
+}
+
+void IrSwitcher::finishSwitch()
+{
+    lastSwitchSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - incoming->loadTicks);
+
+    if (active != nullptr)
+        retire(std::move(active));
+
+    active = std::move(incoming);
+    currentIRSize = active->convolution.getCurrentIRSize();
+    fading = false;
+    switching = handoff.load() != nullptr;
+}
+
+void IrSwitcher::retire(std::unique_ptr<Engine> engine)
+{
+    jassert(canRetire());
+
+    int start1, size1, start2, size2;
+    retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        retired[(size_t)start1] = engine.release();
+    else if (size2 > 0)
+        retired[(size_t)start2] = engine.release();
+
+    retiredFifo.finishedWrite(size1 + size2);
+}
+
+void IrSwitcher::deleteRetired()
+{
+    int start1, size1, start2, size2;
+    retiredFifo.prepareToRead(retiredFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        delete retired[(size_t)(start1 + i)];
+    for (int i = 0; i < size2; ++i)
+        delete retired[(size_t)(start2 + i)];
+
+    retiredFifo.finishedRead(size1 + size2);
+}
+
+void IrSwitcher::timerCallback()
+{
+    // engines free their buffers and FFT plans here instead of on the audio thread
+    deleteRetired();
+}
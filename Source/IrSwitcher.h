@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    IrSwitcher.h
+    Created: 16 Oct 2026 2:05:48pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IrBank.h"
+#include "PartitionedConvolution.h"
+
+/**
+ convolution that changes IRs without dropouts.
+ load() builds a second convolution engine for the new IR on the message thread, the audio thread
+ keeps running the old one until the new one has seen a whole IR length of input and is in steady
+ state, then the two are crossfaded (equal power) and the old engine is handed back to the message
+ thread to be deleted.
+ Once a switch started it runs to its end, only the newest load() that came in meanwhile is kept,
+ so quick automation never queues up more than one switch.
+ A kernel can have the EQ in it already (a FIR EQ or the frozen IIR EQ convolved with the IR). Such an
+ engine is fed the input from before the EQ, every other one the EQ'd input, so switching between the two
+ kinds is as seamless as switching IRs. The caller asks which inputs are needed before each block.
+ */
+class IrSwitcher : private juce::Timer
+{
+public:
+    IrSwitcher();
+    ~IrSwitcher() override;
+
+    // audio must be stopped, any thread the host prepares on. The IR that was loaded last is kept
+    // if it is at the new rate, otherwise nothing is convolved until the next load()
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // message thread
+    void load(std::shared_ptr<const ImpulseResponse> ir, bool includesEq = false);
+    void setCrossfadeTime(double seconds) { crossfadeSeconds.store(juce::jmax(0.0, seconds)); }
+
+    // audio thread. beginBlock() picks up what load() handed over, call it once per block before the rest
+    void beginBlock();
+    // the EQ'd input is also what passes through before the first IR is in
+    bool needsEqInput() const;
+    bool needsDryInput() const;
+    // dryInput is the input from before the EQ, only read while needsDryInput()
+    void process(const juce::dsp::ProcessContextReplacing<float>& context, const juce::dsp::AudioBlock<float>& dryInput = {});
+
+    // size of the IR that is being heard, 0 before the first one was installed
+    int getCurrentIRSize() const { return currentIRSize.load(); }
+
+    // time from load() until the new IR was fully faded in, for the last switch that completed
+    double getLastSwitchTime() const { return lastSwitchSeconds.load(); }
+    bool isSwitching() const { return switching.load(); }
+private:
+    struct Engine
+    {
+        PartitionedConvolution convolution;
+        juce::int64 loadTicks = 0;
+        int samplesProcessed = 0;
+        bool includesEq = false;
+    };
+
+    std::unique_ptr<Engine> makeEngine(const ImpulseResponse& ir, juce::int64 loadTicks, bool includesEq);
+    bool activeHasIR() const { return active != nullptr && active->convolution.getCurrentIRSize() > 0; }
+    void processActive(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& dryInput);
+    void processChunk(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& dryInput);
+    bool canRetire() const { return retiredFifo.getFreeSpace() > 0; }
+    void retire(std::unique_ptr<Engine> engine);
+    void finishSwitch();
+    void deleteRetired();
+    void timerCallback() override;
+
+    juce::dsp::ProcessSpec spec{};
+    std::shared_ptr<const ImpulseResponse> currentIR;
+    bool currentIncludesEq = false;
+
+    // owned by the audio thread while it is running
+    std::unique_ptr<Engine> active, incoming;
+    juce::AudioBuffer<float> scratch;
+    int fadePosition = 0, fadeLength = 0;
+    bool fading = false;
+
+    // message thread -> audio thread
+    std::atomic<Engine*> handoff{ nullptr };
+
+    // audio thread -> message thread, deleted in timerCallback()
+    static constexpr int retiredCapacity = 16;
+    juce::AbstractFifo retiredFifo{ retiredCapacity };
+    std::array<Engine*, retiredCapacity> retired{};
+
+    std::atomic<double> crossfadeSeconds{ 0.05 }, lastSwitchSeconds{ 0.0 };
+    std::atomic<int> currentIRSize{ 0 };
+    std::atomic<bool> switching{ false };
+};
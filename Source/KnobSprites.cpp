@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    KnobSprites.cpp
+    Created: 16 Oct 2026 6:10:44pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "KnobSprites.h"
+
+void KnobSprites::draw(juce::Graphics& g, const void* pngData, int pngDataSize, juce::Rectangle<float> bounds,
+                       float sliderPosProportional, float rotaryStartAngle, float rotaryEndAngle)
+{
+    using namespace juce;
+
+    const auto size = roundToInt(jmin(bounds.getWidth(), bounds.getHeight()));
+    if (size <= 0)
+        return;
+
+    const auto now = Time::getMillisecondCounter();
+    const auto key = std::make_pair(pngData, size);
+    auto found = strips.find(key);
+    if (found == strips.end())
+    {
+        evictUnused(now);
+        found = strips.emplace(key, Strip()).first;
+    }
+
+    auto& strip = found->second;
+    strip.lastDrawn = now;
+
+    if (strip.scaledKnob.isNull() || strip.startAngle != rotaryStartAngle || strip.endAngle != rotaryEndAngle)
+    {
+        const auto knob = ImageCache::getFromMemory(pngData, pngDataSize);
+        strip.scaledKnob = knob.rescaled(size, size, Graphics::highResamplingQuality);
+        strip.frames.assign((size_t)numFrames, Image());
+        strip.startAngle = rotaryStartAngle;
+        strip.endAngle = rotaryEndAngle;
+    }
+
+    const auto frame = roundToInt(jlimit(0.f, 1.f, sliderPosProportional) * (float)(numFrames - 1));
+    auto& image = strip.frames[(size_t)frame];
+    if (image.isNull())
+    {
+        const auto angle = jmap((float)frame / (float)(numFrames - 1), rotaryStartAngle, rotaryEndAngle);
+
+        image = Image(Image::ARGB, size, size, true);
+        Graphics fg(image);
+        fg.drawImageTransformed(strip.scaledKnob, AffineTransform::rotated(angle, size * 0.5f, size * 0.5f));
+    }
+
+    g.drawImageAt(image, roundToInt(bounds.getX()), roundToInt(bounds.getY()));
+}
+
+void KnobSprites::evictUnused(juce::uint32 now)
+{
+    for (auto it = strips.begin(); it != strips.end();)
+    {
+        if (now - it->second.lastDrawn > evictAfterMs)
+            it = strips.erase(it);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    KnobSprites.h
+    Created: 16 Oct 2026 6:10:44pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ rotated knob images, rendered once per knob image, size and angle step instead of decoding, rescaling and
+ rotating the PNG on every slider repaint. Every size gets a strip of numFrames frames, one per angle step,
+ a frame is allocated and rendered the first time it is needed and after that drawing a knob is a plain
+ image copy. Strips of sizes that were not drawn for a while (the editor was resized) are dropped when the
+ next new size comes in.
+ Shared by all look and feels of all open editors through a juce::SharedResourcePointer. Message thread only.
+ */
+class KnobSprites
+{
+public:
+    static constexpr int numFrames = 128;   // about 2.3 degrees apart over the rotary range of the sliders
+
+    void draw(juce::Graphics& g, const void* pngData, int pngDataSize, juce::Rectangle<float> bounds,
+              float sliderPosProportional, float rotaryStartAngle, float rotaryEndAngle);
+private:
+    // a knob that is shown but not moved is not repainted, dropping it costs one rescale when it is
+    static constexpr juce::uint32 evictAfterMs = 10000;
+
+    struct Strip
+    {
+        juce::Image scaledKnob;               // the PNG at this size, rotated into the frames
+        std::vector<juce::Image> frames;      // numFrames of size x size, null until first drawn
+        float startAngle = 0, endAngle = 0;
+        juce::uint32 lastDrawn = 0;
+    };
+
+    void evictUnused(juce::uint32 now);
+
+    std::map<std::pair<const void*, int>, Strip> strips;   // by PNG and size
+};
@@ -0,0 +1,291 @@
+/*
+  ==============================================================================
+
+    LevelMeter.cpp
+    Created: 16 Oct 2026 6:37:05pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+namespace
+{
+    // four independent partial sums, laid out so the compiler can keep them in one vector register
+    double sumOfSquares(const float* data, int numSamples)
+    {
+        float sums[4] = {};
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+            for (int j = 0; j < 4; ++j)
+                sums[j] += data[i + j] * data[i + j];
+
+        for (; i < numSamples; ++i)
+            sums[0] += data[i] * data[i];
+
+        return (double)sums[0] + sums[1] + sums[2] + sums[3];
+    }
+
+    float toLufs(double meanSquare)
+    {
+        return meanSquare > 0.0 ? (float)(-0.691 + 10.0 * std::log10(meanSquare)) : -100.f;
+    }
+}
+
+void LevelMeter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    sliceLength = juce::jmax(1, juce::roundToInt(sampleRate * sliceMs / 1000.0));
+    releasePerSample = (float)std::pow(10.0, -20.0 / 20.0 / sampleRate);
+
+    // 4x interpolator: Kaiser windowed sinc (beta 5), every phase scaled to unity gain at DC
+    const auto numTaps = phases * tapsPerPhase;
+    const auto centre = (numTaps - 1) * 0.5;
+    auto besselI0 = [](double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; term > 1.0e-12 * sum; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    const auto beta = 5.0;
+    for (int p = 0; p < phases; ++p)
+    {
+        double phaseSum = 0;
+        for (int k = 0; k < tapsPerPhase; ++k)
+        {
+            const auto n = p + phases * k;
+            const auto t = (n - centre) / phases;
+            const auto sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+            const auto r = (n - centre) / (centre + 0.5);
+            const auto tap = sinc * besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - r * r))) / besselI0(beta);
+            interpolator[(size_t)p][(size_t)k] = (float)tap;
+            phaseSum += tap;
+        }
+
+        for (auto& tap : interpolator[(size_t)p])
+            tap = (float)(tap / phaseSum);
+    }
+
+    // K-weighting of BS.1770 for any sample rate: the high shelf and the RLB high pass
+    const auto shelfK = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+    const auto shelfQ = 0.7071752369554196;
+    const auto vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const auto vb = std::pow(vh, 0.4996667741545416);
+    const auto shelfA0 = 1.0 + shelfK / shelfQ + shelfK * shelfK;
+
+    const auto passK = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+    const auto passQ = 0.5003270373238773;
+    const auto passA0 = 1.0 + passK / passQ + passK * passK;
+
+    phaseOutput.assign((size_t)sliceLength, 0.f);
+    weighted.assign((size_t)shortTermSlices, 0.0);
+
+    for (auto& state : channels)
+    {
+        state.shelf.b0 = (vh + vb * shelfK / shelfQ + shelfK * shelfK) / shelfA0;
+        state.shelf.b1 = 2.0 * (shelfK * shelfK - vh) / shelfA0;
+        state.shelf.b2 = (vh - vb * shelfK / shelfQ + shelfK * shelfK) / shelfA0;
+        state.shelf.a1 = 2.0 * (shelfK * shelfK - 1.0) / shelfA0;
+        state.shelf.a2 = (1.0 - shelfK / shelfQ + shelfK * shelfK) / shelfA0;
+
+        state.highPass.b0 = 1.0;
+        state.highPass.b1 = -2.0;
+        state.highPass.b2 = 1.0;
+        state.highPass.a1 = 2.0 * (passK * passK - 1.0) / passA0;
+        state.highPass.a2 = (1.0 - passK / passQ + passK * passK) / passA0;
+
+        state.interpolatorInput.assign((size_t)(tapsPerPhase - 1 + sliceLength), 0.f);
+        state.squares.assign((size_t)shortTermSlices, 0.0);
+    }
+
+    reset();
+}
+
+void LevelMeter::reset()
+{
+    for (auto& state : channels)
+    {
+        state.peak = state.truePeak = 0.f;
+        state.shelf.z1 = state.shelf.z2 = state.highPass.z1 = state.highPass.z2 = 0.0;
+        state.sliceSquares = state.sliceWeighted = 0.0;
+        std::fill(state.interpolatorInput.begin(), state.interpolatorInput.end(), 0.f);
+        std::fill(state.squares.begin(), state.squares.end(), 0.0);
+    }
+
+    std::fill(weighted.begin(), weighted.end(), 0.0);
+    histogramCount.fill(0);
+    histogramEnergy.fill(0.0);
+    sliceFill = slicePosition = 0;
+    slicesDone = 0;
+    snapshot = {};
+}
+
+void LevelMeter::process(const juce::AudioBuffer<float>& buffer)
+{
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+    const auto numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples;)
+    {
+        // never across the end of a slice, whatever size the host blocks are
+        const auto n = juce::jmin(numSamples - start, sliceLength - sliceFill);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            measure(channels[(size_t)ch], buffer.getReadPointer(ch) + start, n);
+
+        sliceFill += n;
+        start += n;
+
+        if (sliceFill == sliceLength)
+        {
+            endSlice(numChannels);
+            sliceFill = 0;
+        }
+    }
+}
+
+void LevelMeter::measure(ChannelState& state, const float* data, int numSamples)
+{
+    const auto decay = std::pow(releasePerSample, (float)numSamples);
+
+    // sample peak
+    const auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+    const auto peak = juce::jmax(-range.getStart(), range.getEnd());
+    state.peak = juce::jmax(peak, state.peak * decay);
+
+    // true peak: every phase of the interpolator is one multiply-add pass per tap over the slice
+    constexpr int history = tapsPerPhase - 1;
+    auto* input = state.interpolatorInput.data();
+    juce::FloatVectorOperations::copy(input + history, data, numSamples);
+
+    auto truePeak = peak;
+    for (const auto& taps : interpolator)
+    {
+        juce::FloatVectorOperations::clear(phaseOutput.data(), numSamples);
+        for (int k = 0; k < tapsPerPhase; ++k)
+            juce::FloatVectorOperations::addWithMultiply(phaseOutput.data(), input + history - k, taps[(size_t)k], numSamples);
+
+        const auto phaseRange = juce::FloatVectorOperations::findMinAndMax(phaseOutput.data(), numSamples);
+        truePeak = juce::jmax(truePeak, -phaseRange.getStart(), phaseRange.getEnd());
+    }
+
+    state.truePeak = juce::jmax(truePeak, state.truePeak * decay);
+    snapshot.maxTruePeakDb = juce::jmax(snapshot.maxTruePeakDb, juce::Decibels::gainToDecibels(truePeak, -100.f));
+    std::copy(input + numSamples, input + numSamples + history, input);
+
+    // RMS and loudness
+    state.sliceSquares += sumOfSquares(data, numSamples);
+
+    double weightedSquares = 0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto y = state.highPass.process(state.shelf.process(data[i]));
+        weightedSquares += y * y;
+    }
+    state.sliceWeighted += weightedSquares;
+}
+
+void LevelMeter::endSlice(int numChannels)
+{
+    double weightedSum = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto& state = channels[(size_t)ch];
+        state.squares[(size_t)slicePosition] = state.sliceSquares;
+        weightedSum += state.sliceWeighted;   // every channel weighted 1, as for L and R in BS.1770
+        state.sliceSquares = state.sliceWeighted = 0.0;
+    }
+
+    weighted[(size_t)slicePosition] = weightedSum;
+    slicePosition = (slicePosition + 1) % shortTermSlices;
+    ++slicesDone;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto& state = channels[(size_t)ch];
+        snapshot.peakDb[(size_t)ch] = juce::Decibels::gainToDecibels(state.peak, -100.f);
+        snapshot.truePeakDb[(size_t)ch] = juce::Decibels::gainToDecibels(state.truePeak, -100.f);
+        snapshot.rmsDb[(size_t)ch] = juce::Decibels::gainToDecibels((float)std::sqrt(windowMeanSquare(state.squares, rmsSlices)), -100.f);
+    }
+
+    // mono is measured once and shown on both meters
+    if (numChannels == 1)
+    {
+        snapshot.peakDb[1] = snapshot.peakDb[0];
+        snapshot.truePeakDb[1] = snapshot.truePeakDb[0];
+        snapshot.rmsDb[1] = snapshot.rmsDb[0];
+    }
+
+    const auto momentary = windowMeanSquare(weighted, momentarySlices);
+    snapshot.momentaryLufs = toLufs(momentary);
+    snapshot.shortTermLufs = toLufs(windowMeanSquare(weighted, shortTermSlices));
+
+    if (slicesDone >= momentarySlices && slicesDone % gatingStepSlices == 0)
+    {
+        addGatingBlock(momentary);
+        snapshot.integratedLufs = getIntegratedLoudness();
+    }
+
+    snapshots.push(snapshot);
+}
+
+double LevelMeter::windowMeanSquare(const std::vector<double>& ring, int numSlices) const
+{
+    // right after a reset the window only covers what was measured so far
+    const auto count = (int)juce::jmin((juce::int64)numSlices, slicesDone);
+    if (count == 0)
+        return 0.0;
+
+    double sum = 0;
+    for (int i = 1; i <= count; ++i)
+        sum += ring[(size_t)((slicePosition - i + shortTermSlices) % shortTermSlices)];
+
+    return sum / ((double)count * sliceLength);
+}
+
+void LevelMeter::addGatingBlock(double meanSquare)
+{
+    // absolute gate at -70 LUFS, blocks below are never counted
+    const auto loudness = toLufs(meanSquare);
+    if (loudness < -70.f)
+        return;
+
+    const auto bin = juce::jlimit(0, histogramBins - 1, (int)((loudness + 70.f) * 10.f));
+    ++histogramCount[(size_t)bin];
+    histogramEnergy[(size_t)bin] += meanSquare;
+}
+
+float LevelMeter::getIntegratedLoudness() const
+{
+    // relative gate 10 LU below the loudness of everything above the absolute gate. The energies are summed
+    // per bin, only where the relative gate falls is rounded to the 0.1 LU of a bin
+    juce::int64 count = 0;
+    double energy = 0;
+    for (int bin = 0; bin < histogramBins; ++bin)
+    {
+        count += histogramCount[(size_t)bin];
+        energy += histogramEnergy[(size_t)bin];
+    }
+
+    if (count == 0)
+        return -100.f;
+
+    const auto relativeGate = toLufs(energy / (double)count) - 10.f;
+    const auto firstBin = juce::jlimit(0, histogramBins, (int)std::ceil((relativeGate + 70.f) * 10.f));
+
+    count = 0;
+    energy = 0;
+    for (int bin = firstBin; bin < histogramBins; ++bin)
+    {
+        count += histogramCount[(size_t)bin];
+        energy += histogramEnergy[(size_t)bin];
+    }
+
+    return count > 0 ? toLufs(energy / (double)count) : -100.f;
+}
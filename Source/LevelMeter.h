@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+    Created: 16 Oct 2026 6:37:05pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+// what the editor shows, all levels in dB / LUFS, index 0 is buffer channel 0
+struct MeterSnapshot
+{
+    std::array<float, 2> peakDb{ { -100.f, -100.f } };
+    std::array<float, 2> truePeakDb{ { -100.f, -100.f } };
+    std::array<float, 2> rmsDb{ { -100.f, -100.f } };
+    float momentaryLufs = -100.f, shortTermLufs = -100.f, integratedLufs = -100.f;
+    float maxTruePeakDb = -100.f;   // since the last reset
+};
+
+/**
+ meters for the processed signal, fed by processBlock() and read by the editor:
+  - sample peak and true peak (4x oversampled with a 48 tap interpolator as in BS.1770 annex 2), 20 dB/s release
+  - RMS over a fixed 300 ms window
+  - EBU R128 loudness: K-weighted, momentary (400 ms), short term (3 s) and gated integrated
+ Everything is measured in 10 ms slices that end at exact sample positions, so nothing depends on the host
+ block size. Peak search, the interpolator phases and the sums of squares are straight loops over the slice
+ that vectorise, only the K-weighting biquads run sample by sample.
+ A MeterSnapshot is pushed into a TripleBuffer at the end of every slice.
+ */
+class LevelMeter
+{
+public:
+    static constexpr int maxChannels = 2;
+
+    // message thread, before processing. Clears everything measured so far
+    void prepare(double sampleRate);
+
+    // audio thread
+    void reset();
+    void process(const juce::AudioBuffer<float>& buffer);
+
+    // any thread but the audio thread, false if nothing new came since the last call
+    bool pullSnapshot(MeterSnapshot& snapshot) { return snapshots.pull(snapshot); }
+private:
+    static constexpr int sliceMs = 10;
+    static constexpr int rmsSlices = 30, momentarySlices = 40, shortTermSlices = 300;
+    static constexpr int gatingStepSlices = 10;                       // a 400 ms gating block every 100 ms
+    static constexpr int phases = 4, tapsPerPhase = 12;
+    static constexpr int histogramBins = 800;                         // gating blocks from -70 to +10 LUFS in 0.1 LU
+
+    struct Biquad
+    {
+        double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+        double z1 = 0, z2 = 0;
+
+        double process(double x)
+        {
+            const auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    struct ChannelState
+    {
+        float peak = 0, truePeak = 0;
+        Biquad shelf, highPass;                 // K-weighting
+        std::vector<float> interpolatorInput;   // last tapsPerPhase - 1 samples, then the current slice
+        double sliceSquares = 0, sliceWeighted = 0;
+        std::vector<double> squares;            // per slice, ring of shortTermSlices
+    };
+
+    void measure(ChannelState& state, const float* data, int numSamples);
+    void endSlice(int numChannels);
+    double windowMeanSquare(const std::vector<double>& ring, int numSlices) const;
+    void addGatingBlock(double meanSquare);
+    float getIntegratedLoudness() const;
+
+    double sampleRate = 44100.0;
+    int sliceLength = 441, sliceFill = 0;
+    float releasePerSample = 1.f;
+
+    std::array<std::array<float, tapsPerPhase>, phases> interpolator{};
+    std::vector<float> phaseOutput;
+
+    std::array<ChannelState, maxChannels> channels;
+    std::vector<double> weighted;               // K-weighted sum of the channels per slice, ring of shortTermSlices
+    int slicePosition = 0;
+    juce::int64 slicesDone = 0;
+
+    std::array<juce::int64, histogramBins> histogramCount{};
+    std::array<double, histogramBins> histogramEnergy{};
+
+    MeterSnapshot snapshot;
+    TripleBuffer<MeterSnapshot> snapshots;
+};
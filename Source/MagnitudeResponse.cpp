@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    MagnitudeResponse.cpp
+    Created: 16 Oct 2026 5:48:12pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "MagnitudeResponse.h"
+
+void MagnitudeResponse::prepare(int numPoints, double sampleRate, double minFreq, double maxFreq)
+{
+    if (numPoints == preparedPoints && sampleRate == preparedRate && minFreq == preparedMin && maxFreq == preparedMax)
+        return;
+
+    preparedPoints = numPoints;
+    preparedRate = sampleRate;
+    preparedMin = minFreq;
+    preparedMax = maxFreq;
+
+    phi.resize((size_t)juce::jmax(0, numPoints));
+    frequencies.resize(phi.size());
+    magnitude.resize(phi.size());
+
+    for (size_t i = 0; i < phi.size(); ++i)
+    {
+        // point i is pixel column i of a numPoints wide graph
+        const auto proportion = (double)i / (double)numPoints;
+        const auto freq = juce::mapToLog10(proportion, minFreq, maxFreq);
+        const auto s = std::sin(juce::MathConstants<double>::pi * freq / sampleRate);
+        phi[i] = s * s;
+        frequencies[i] = freq;
+    }
+
+    reset();
+}
+
+void MagnitudeResponse::reset()
+{
+    std::fill(magnitude.begin(), magnitude.end(), 1.0);
+}
+
+void MagnitudeResponse::addBiquad(const juce::dsp::IIR::Coefficients<float>& coefficients)
+{
+    // JUCE keeps b0 b1 b2 a1 a2 with a0 = 1, higher orders aren't drawn by this
+    jassert(coefficients.coefficients.size() == 5);
+    const auto* c = coefficients.coefficients.begin();
+    const double b0 = c[0], b1 = c[1], b2 = c[2], a0 = 1.0, a1 = c[3], a2 = c[4];
+
+    // |H|^2 = (p0 + p1 phi + p2 phi^2) / (q0 + q1 phi + q2 phi^2)
+    const auto p0 = (b0 + b1 + b2) * (b0 + b1 + b2), p1 = -4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2), p2 = 16.0 * b0 * b2;
+    const auto q0 = (a0 + a1 + a2) * (a0 + a1 + a2), q1 = -4.0 * (a0 * a1 + 4.0 * a0 * a2 + a1 * a2), q2 = 16.0 * a0 * a2;
+
+    const auto numPoints = phi.size();
+    const auto* x = phi.data();
+    auto* m = magnitude.data();
+
+    for (size_t i = 0; i < numPoints; ++i)
+        m[i] *= (p0 + x[i] * (p1 + x[i] * p2)) / (q0 + x[i] * (q1 + x[i] * q2));
+}
+
+void MagnitudeResponse::addMagnitude(const std::function<double(double frequency)>& magnitudeAt)
+{
+    for (size_t i = 0; i < magnitude.size(); ++i)
+    {
+        const auto m = magnitudeAt(frequencies[i]);
+        magnitude[i] *= m * m;
+    }
+}
+
+double MagnitudeResponse::getDecibels(int point) const
+{
+    // 10 log10 of the power, the same as 20 log10 |H|
+    return 10.0 * std::log10(juce::jmax(magnitude[(size_t)point], 1.0e-20));
+}
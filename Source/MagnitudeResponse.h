@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    MagnitudeResponse.h
+    Created: 16 Oct 2026 5:48:12pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ magnitude response of a cascade of biquads at many frequencies at once, for drawing.
+ The log spaced frequencies are turned into phi = sin^2(w/2) once per size and sample rate, after that every
+ biquad is a few multiply-adds per point in plain loops the compiler vectorises. |H|^2 is evaluated in the
+ phi form from the RBJ cookbook, which keeps its precision near DC where the cos(w) form cancels.
+ */
+class MagnitudeResponse
+{
+public:
+    // numPoints log spaced frequencies from minFreq up to maxFreq. Does nothing if nothing changed
+    void prepare(int numPoints, double sampleRate, double minFreq = 20.0, double maxFreq = 20000.0);
+
+    // back to 0 dB everywhere
+    void reset();
+    void addBiquad(const juce::dsp::IIR::Coefficients<float>& coefficients);
+    // any response given as |H| at a frequency in Hz, e.g. an analog prototype
+    void addMagnitude(const std::function<double(double frequency)>& magnitudeAt);
+
+    int getNumPoints() const { return (int)phi.size(); }
+    double getDecibels(int point) const;
+private:
+    std::vector<double> phi;         // sin^2(w/2) per point
+    std::vector<double> frequencies; // in Hz, per point
+    std::vector<double> magnitude;   // |H|^2 of everything added since reset()
+    int preparedPoints = 0;
+    double preparedRate = 0, preparedMin = 0, preparedMax = 0;
+};
@@ -0,0 +1,386 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolution.cpp
+    Created: 16 Oct 2026 4:02:51pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolution.h"
+
+PartitionedConvolution::Worker::Worker() : juce::Thread("IR tail convolution")
+{
+    startThread(juce::Thread::realtimeAudioPriority);
+}
+
+PartitionedConvolution::Worker::~Worker()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(5000);
+}
+
+void PartitionedConvolution::Worker::add(PartitionedConvolution* engine)
+{
+    const juce::ScopedLock sl(lock);
+    if (std::find(engines.begin(), engines.end(), engine) == engines.end())
+        engines.push_back(engine);
+}
+
+void PartitionedConvolution::Worker::remove(PartitionedConvolution* engine)
+{
+    // run() holds the lock while it convolves, so no job of the engine is running once this has it
+    const juce::ScopedLock sl(lock);
+    engines.erase(std::remove(engines.begin(), engines.end(), engine), engines.end());
+}
+
+void PartitionedConvolution::Worker::run()
+{
+    while (!threadShouldExit())
+    {
+        bool ranJob = false;
+        {
+            const juce::ScopedLock sl(lock);
+            for (auto* engine : engines)
+                ranJob = engine->runPendingJobs() || ranJob;
+        }
+
+        // a job handed over while the engines were gone through has signalled already, so this returns right away
+        if (!ranJob)
+            wait(-1);
+    }
+}
+
+PartitionedConvolution::PartitionedConvolution()
+{
+    // audio thread part right after the head, background part where the audio thread leaves off
+    levels[0].blockSize = level0BlockSize;
+    levels[0].offset = headSize;
+    levels[1].blockSize = level1BlockSize;
+    levels[1].offset = level1Offset;
+    levels[1].onWorker = true;
+}
+
+double PartitionedConvolution::getRelativeCost(int irLength)
+{
+    // an FFT and its inverse per block come to about 8 partitions' worth
+    constexpr double fftCost = 8.0;
+
+    const auto level0 = juce::jmax(0, (juce::jmin(irLength, (int)level1Offset) - (int)headSize + level0BlockSize - 1) / level0BlockSize);
+    const auto level1 = juce::jmax(0, (irLength - (int)level1Offset + level1BlockSize - 1) / level1BlockSize);
+
+    return (level0 > 0 ? level0 + fftCost : 0.0) + (level1 > 0 ? level1 + fftCost : 0.0);
+}
+
+PartitionedConvolution::~PartitionedConvolution()
+{
+    worker->remove(this);
+}
+
+void PartitionedConvolution::prepare(const juce::dsp::ProcessSpec& spec, const ImpulseResponse& ir)
+{
+    worker->remove(this);
+
+    jassert(juce::roundToInt(ir.sampleRate) == juce::roundToInt(spec.sampleRate));
+
+    numChannels = (int)spec.numChannels;
+    numIRChannels = juce::jmax(1, ir.buffer.getNumChannels());
+    irSize = ir.buffer.getNumSamples();
+    packed = numChannels == 2 && numIRChannels == 1;
+
+    auto irSample = [&ir](int channel, int index)
+    {
+        return index < ir.buffer.getNumSamples() ? ir.buffer.getSample(juce::jmin(channel, ir.buffer.getNumChannels() - 1), index) : 0.f;
+    };
+
+    head.assign((size_t)(numIRChannels * headSize), 0.f);
+    for (int ch = 0; ch < numIRChannels; ++ch)
+        for (int j = 0; j < headSize; ++j)
+            head[(size_t)(ch * headSize + j)] = irSample(ch, j);
+
+    headHistory.assign((size_t)(numChannels * 2 * headSize), 0.f);
+
+    int maxReach = headSize;
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        auto& level = levels[l];
+        const auto end = l + 1 < levels.size() ? levels[l + 1].offset : irSize;
+        const auto fftSize = 2 * level.blockSize;
+        const auto numBins = packed ? fftSize : level.blockSize + 1;
+
+        level.numPartitions = juce::jmax(0, (juce::jmin(end, irSize) - level.offset + level.blockSize - 1) / level.blockSize);
+        level.fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(fftSize)));
+        level.fftBuffer.assign((size_t)(2 * fftSize), 0.f);
+        level.accumulator.assign((size_t)numBins, {});
+        level.filling.assign((size_t)(numChannels * level.blockSize), 0.f);
+        level.input.assign(level.filling.size(), 0.f);
+        level.output.assign((size_t)(numChannels * fftSize), 0.f);
+        level.history.assign((size_t)((packed ? 1 : numChannels) * level.numPartitions), std::vector<std::complex<float>>((size_t)numBins));
+        level.packedInput.assign(packed ? (size_t)fftSize : 0, {});
+        level.partitions.assign((size_t)(numIRChannels * level.numPartitions), {});
+
+        // spectra of the IR partitions, done once here instead of per block
+        for (int ch = 0; ch < numIRChannels; ++ch)
+        {
+            for (int p = 0; p < level.numPartitions; ++p)
+            {
+                std::fill(level.fftBuffer.begin(), level.fftBuffer.end(), 0.f);
+                for (int i = 0; i < level.blockSize; ++i)
+                {
+                    const auto index = level.offset + p * level.blockSize + i;
+                    level.fftBuffer[(size_t)i] = index < end ? irSample(ch, index) : 0.f;
+                }
+
+                level.fft->performRealOnlyForwardTransform(level.fftBuffer.data(), !packed);
+                const auto* bins = reinterpret_cast<const std::complex<float>*>(level.fftBuffer.data());
+                level.partitions[(size_t)(ch * level.numPartitions + p)].assign(bins, bins + numBins);
+            }
+        }
+
+        if (level.numPartitions > 0)
+            maxReach = juce::jmax(maxReach, level.offset + 2 * level.blockSize);
+    }
+
+    overlapSize = juce::nextPowerOfTwo(maxReach + levels.back().blockSize);
+    overlap.assign((size_t)(numChannels * overlapSize), 0.f);
+
+    reset();
+
+    if (levels[1].numPartitions > 0)
+        worker->add(this);
+}
+
+void PartitionedConvolution::reset()
+{
+    std::fill(headHistory.begin(), headHistory.end(), 0.f);
+    std::fill(overlap.begin(), overlap.end(), 0.f);
+    headPosition = 0;
+    time = 0;
+
+    for (auto& level : levels)
+    {
+        // only called while nothing is processing, a job that is still running finishes first
+        while (level.job.load() == Job_Running)
+            juce::Thread::yield();
+
+        for (auto& spectrum : level.history)
+            std::fill(spectrum.begin(), spectrum.end(), std::complex<float>());
+
+        std::fill(level.filling.begin(), level.filling.end(), 0.f);
+        level.historyPosition = 0;
+        level.job = Job_Idle;
+    }
+}
+
+void PartitionedConvolution::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    const auto& block = context.getOutputBlock();
+    const auto channels = juce::jmin((int)block.getNumChannels(), numChannels);
+    const auto numSamples = (int)block.getNumSamples();
+    const auto smallestBlock = levels[0].blockSize;
+    const auto overlapMask = overlapSize - 1;
+
+    for (int start = 0; start < numSamples;)
+    {
+        // chunks never cross a block boundary of the smallest level, so none of the others either
+        const auto fill = (int)(time % smallestBlock);
+        const auto n = juce::jmin(numSamples - start, smallestBlock - fill);
+        auto position = headPosition;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto* data = block.getChannelPointer((size_t)ch) + start;
+            const auto* h = head.data() + juce::jmin(ch, numIRChannels - 1) * headSize;
+            auto* history = headHistory.data() + ch * 2 * headSize;
+            auto* out = overlap.data() + ch * overlapSize;
+            position = headPosition;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const auto x = data[i];
+                const auto t = time + i;
+
+                for (auto& level : levels)
+                    if (level.numPartitions > 0)
+                        level.filling[(size_t)(ch * level.blockSize + (int)(t % level.blockSize))] = x;
+
+                // newest sample first, history[position + j] is x[t - j]
+                position = (position + headSize - 1) % headSize;
+                history[position] = history[position + headSize] = x;
+
+                float y = 0.f;
+                for (int j = 0; j < headSize; ++j)
+                    y += h[j] * history[position + j];
+
+                auto& tail = out[(int)(t & overlapMask)];
+                data[i] = y + tail;
+                tail = 0.f;
+            }
+        }
+
+        headPosition = position;
+        time += n;
+        start += n;
+
+        for (auto& level : levels)
+        {
+            if (level.numPartitions == 0 || time % level.blockSize != 0)
+                continue;
+
+            if (level.onWorker)
+            {
+                // result of the block before last is due now, then the block that just filled up is handed over
+                finishJob(level);
+
+                level.input.swap(level.filling);
+                level.blockTime = time - level.blockSize;
+                level.job = Job_Pending;
+                worker->wake();
+            }
+            else
+            {
+                level.input.swap(level.filling);
+                level.blockTime = time - level.blockSize;
+                convolve(level);
+                addToOutput(level);
+            }
+        }
+    }
+}
+
+void PartitionedConvolution::finishJob(Level& level)
+{
+    if (level.job.load() == Job_Idle)
+        return;
+
+    int expected = Job_Pending;
+    if (level.job.compare_exchange_strong(expected, Job_Running))
+    {
+        // the thread didn't get to it in time
+        convolve(level);
+        level.job = Job_Done;
+    }
+
+    while (level.job.load() != Job_Done)
+        juce::Thread::yield();
+
+    addToOutput(level);
+    level.job = Job_Idle;
+}
+
+bool PartitionedConvolution::runPendingJobs()
+{
+    bool ranJob = false;
+
+    for (auto& level : levels)
+    {
+        int expected = Job_Pending;
+        if (level.onWorker && level.job.compare_exchange_strong(expected, Job_Running))
+        {
+            convolve(level);
+            level.job = Job_Done;
+            ranJob = true;
+        }
+    }
+
+    return ranJob;
+}
+
+void PartitionedConvolution::multiplyAccumulate(Level& level, const std::vector<std::complex<float>>* history,
+                                                const std::vector<std::complex<float>>* partitions, int numBins)
+{
+    std::fill(level.accumulator.begin(), level.accumulator.end(), std::complex<float>());
+
+    for (int p = 0; p < level.numPartitions; ++p)
+    {
+        const auto& x = history[(level.historyPosition - p + level.numPartitions) % level.numPartitions];
+        const auto& h = partitions[p];
+
+        for (int k = 0; k < numBins; ++k)
+            level.accumulator[(size_t)k] += x[(size_t)k] * h[(size_t)k];
+    }
+}
+
+void PartitionedConvolution::convolvePacked(Level& level)
+{
+    const auto fftSize = 2 * level.blockSize;
+    auto* bins = reinterpret_cast<std::complex<float>*>(level.fftBuffer.data());
+
+    // the upper half of packedInput is never written, it stays the zero padding
+    for (int i = 0; i < level.blockSize; ++i)
+        level.packedInput[(size_t)i] = { level.input[(size_t)i], level.input[(size_t)(level.blockSize + i)] };
+
+    level.fft->perform(level.packedInput.data(), bins, false);
+    level.history[(size_t)level.historyPosition].assign(bins, bins + fftSize);
+
+    multiplyAccumulate(level, level.history.data(), level.partitions.data(), fftSize);
+
+    // JUCE's inverse already divides by the size
+    level.fft->perform(level.accumulator.data(), bins, true);
+    for (int i = 0; i < fftSize; ++i)
+    {
+        level.output[(size_t)i] = bins[i].real();
+        level.output[(size_t)(fftSize + i)] = bins[i].imag();
+    }
+
+    level.historyPosition = (level.historyPosition + 1) % level.numPartitions;
+}
+
+void PartitionedConvolution::convolve(Level& level)
+{
+    if (packed)
+    {
+        convolvePacked(level);
+        return;
+    }
+
+    const auto fftSize = 2 * level.blockSize;
+    const auto numBins = level.blockSize + 1;
+    auto* bins = reinterpret_cast<std::complex<float>*>(level.fftBuffer.data());
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        // spectrum of the new block goes into the frequency domain delay line
+        std::fill(level.fftBuffer.begin(), level.fftBuffer.end(), 0.f);
+        std::copy_n(level.input.data() + ch * level.blockSize, level.blockSize, level.fftBuffer.data());
+        level.fft->performRealOnlyForwardTransform(level.fftBuffer.data(), true);
+
+        auto* history = level.history.data() + ch * level.numPartitions;
+        history[level.historyPosition].assign(bins, bins + numBins);
+
+        // sum of every stored block times the partition that lines up with it
+        multiplyAccumulate(level, history, level.partitions.data() + juce::jmin(ch, numIRChannels - 1) * level.numPartitions, numBins);
+
+        // mirrored for the inverse transform, JUCE's inverse already divides by the size
+        for (int k = 0; k < numBins; ++k)
+            bins[k] = level.accumulator[(size_t)k];
+        for (int k = numBins; k < fftSize; ++k)
+            bins[k] = std::conj(level.accumulator[(size_t)(fftSize - k)]);
+
+        level.fft->performRealOnlyInverseTransform(level.fftBuffer.data());
+        std::copy_n(level.fftBuffer.data(), fftSize, level.output.data() + ch * fftSize);
+    }
+
+    level.historyPosition = (level.historyPosition + 1) % level.numPartitions;
+}
+
+void PartitionedConvolution::addToOutput(const Level& level)
+{
+    // block k of this level starts to sound at k * blockSize + offset, which is never in the past
+    const auto fftSize = 2 * level.blockSize;
+    const auto overlapMask = overlapSize - 1;
+    const auto first = level.blockTime + level.offset;
+
+    jassert(first >= time);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* out = overlap.data() + ch * overlapSize;
+        const auto* result = level.output.data() + ch * fftSize;
+
+        for (int i = 0; i < fftSize - 1; ++i)
+            out[(int)((first + i) & overlapMask)] += result[i];
+    }
+}
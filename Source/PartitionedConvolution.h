@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolution.h
+    Created: 16 Oct 2026 4:02:51pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IrBank.h"
+
+/**
+ zero latency convolution for one IR, non uniformly partitioned:
+  - IR samples [0, 128) are a direct form FIR, so nothing has to wait for a block to fill up
+  - [128, 2048) uniformly partitioned FFT convolution with 128 sample blocks, on the audio thread
+  - [2048, end) 1024 sample blocks, computed on a worker thread. A block is handed over when
+    it is complete and its result is only needed one block later, which is why that part starts at 2048.
+    If the worker hasn't started on it by then the audio thread does it itself, if it is in the
+    middle of it the audio thread waits, so the output never depends on scheduling.
+    There is one worker per process for every engine of every instance (engines come and go with each
+    IR switch), so the number of realtime threads doesn't grow with them.
+ Blocks of any size can be processed, the host block size doesn't matter for the latency.
+ Channel n uses IR channel n, or the only one for a mono IR.
+ Stereo through a mono IR (every shipped IR is mono) runs packed: left is the real and right the
+ imaginary part of one complex transform, which convolves both with the real IR at once. With JUCE's own
+ FFT a real only transform costs as much as a complex one of the same size, so that halves the FFT work.
+ */
+class PartitionedConvolution
+{
+public:
+    static constexpr int latencySamples = 0;
+
+    PartitionedConvolution();
+    ~PartitionedConvolution();
+
+    // message thread, before the engine is processed. The IR has to be at spec.sampleRate
+    void prepare(const juce::dsp::ProcessSpec& spec, const ImpulseResponse& ir);
+    void reset();
+
+    // audio thread
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    int getCurrentIRSize() const { return irSize; }
+
+    // rough cost per sample of an IR this long, in multiply-accumulates of one partition (about 4 ns per
+    // stereo frame on a current x86 core, whatever the level). The head costs the same for every IR and
+    // isn't counted, every level that is used also pays a forward and an inverse FFT per block
+    static double getRelativeCost(int irLength);
+private:
+    static constexpr int headSize = 128;
+    static constexpr int level0BlockSize = 128, level1BlockSize = 1024, level1Offset = 2048;
+
+    enum JobState { Job_Idle, Job_Pending, Job_Running, Job_Done };
+
+    // runs the pending jobs of every engine that is added to it, one per process through juce::SharedResourcePointer
+    class Worker : private juce::Thread
+    {
+    public:
+        Worker();
+        ~Worker() override;
+
+        // message thread. remove() waits for a job of that engine that is running
+        void add(PartitionedConvolution* engine);
+        void remove(PartitionedConvolution* engine);
+        // audio thread, after a job was handed over
+        void wake() { notify(); }
+    private:
+        void run() override;
+
+        juce::CriticalSection lock;
+        std::vector<PartitionedConvolution*> engines;
+    };
+
+    struct Level
+    {
+        int blockSize = 0, offset = 0, numPartitions = 0;
+        bool onWorker = false;
+
+        std::unique_ptr<juce::dsp::FFT> fft;
+        // blockSize + 1 bins per spectrum, all 2 * blockSize when packed
+        std::vector<std::vector<std::complex<float>>> partitions;  // [irChannel * numPartitions + p][bin]
+        std::vector<std::vector<std::complex<float>>> history;     // [channel * numPartitions + slot][bin], one channel when packed
+        int historyPosition = 0;
+
+        std::vector<float> filling, input;   // [channel * blockSize + i], filled by the audio thread / being convolved
+        std::vector<float> output;           // [channel * 2 * blockSize + i], result of the last convolved block
+        std::vector<float> fftBuffer;
+        std::vector<std::complex<float>> accumulator, packedInput;
+
+        juce::int64 blockTime = 0;           // input time of the block in input/output
+        std::atomic<int> job{ Job_Idle };
+    };
+
+    void convolve(Level& level);
+    void convolvePacked(Level& level);
+    // accumulator = sum over p of history[newest - p] * partitions[p]
+    static void multiplyAccumulate(Level& level, const std::vector<std::complex<float>>* history,
+                                   const std::vector<std::complex<float>>* partitions, int numBins);
+    void addToOutput(const Level& level);
+    void finishJob(Level& level);
+    // worker thread, false if no job was pending
+    bool runPendingJobs();
+
+    int numChannels = 0, numIRChannels = 0, irSize = 0;
+    bool packed = false;
+
+    std::vector<float> head;          // [irChannel * headSize + j]
+    std::vector<float> headHistory;   // [channel * 2 * headSize + i], every sample is written twice so the dot product never wraps
+    int headPosition = 0;
+
+    // output of the partitioned levels, indexed by time modulo its size
+    std::vector<float> overlap;       // [channel * overlapSize + i]
+    int overlapSize = 0;
+
+    std::array<Level, 2> levels;
+    juce::int64 time = 0;
+
+    juce::SharedResourcePointer<Worker> worker;
+};
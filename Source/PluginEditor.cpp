@@ -43,28 +43,8 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, i
 
         //g.fillPath(p);
 
-        // TRYING TO PUT IMAGE HERE
-        juce::Image knobRed = ImageCache::getFromMemory(BinaryData::knob_red_png, BinaryData::knob_red_pngSize);
-        juce::Image knobRedRescaled = knobRed.rescaled(bounds.getWidth() / knobRed.getWidth() * knobRed.getWidth(), bounds.getHeight() / knobRed.getHeight() * knobRed.getHeight(), Graphics::highResamplingQuality);
-        
-        AffineTransform rotator;
-        //if (!slider.isMouseOverOrDragging())
-        //{
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //else
-        //{
-        //    //g.drawImage(knobRed, x, y, width, height, 0, 0, width, height, false);
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //g.drawImageTransformed(knobRed, x, y, width, height, rotator.rotated((float)sliderPosProportional * rotaryEndAngle, (float)(knobRed.getWidth() / 2), (float)(knobRed.getHeight() / 2)), false);
-        //g.drawImage(knobRedRescaled, bounds, RectanglePlacement::stretchToFit, false);
-        int origX = g.getClipBounds().getX();
-        int origY = g.getClipBounds().getY();
-        g.drawImageTransformed(knobRedRescaled, rotator.rotated(sliderAngRad, knobRedRescaled.getWidth() / 2, knobRedRescaled.getHeight() / 2).translated(bounds.getX()-origX, bounds.getY()-origY));
-        
-
-        // TRYING TO PUT IMAGE HERE
+        // pre-rendered for this size and angle step, nothing is decoded or rescaled here
+        knobSprites->draw(g, BinaryData::knob_red_png, BinaryData::knob_red_pngSize, bounds, sliderPosProportional, rotaryStartAngle, rotaryEndAngle);
 
 
         if (slider.isMouseOverOrDragging())
@@ -157,28 +137,8 @@ void LookAndFeelBlue::drawRotarySlider(juce::Graphics& g, int x, int y, int widt
 
         //g.fillPath(p);
 
-        // TRYING TO PUT IMAGE HERE
-        juce::Image knobRed = ImageCache::getFromMemory(BinaryData::knob_blue_png, BinaryData::knob_blue_pngSize);
-        juce::Image knobRedRescaled = knobRed.rescaled(bounds.getWidth() / knobRed.getWidth() * knobRed.getWidth(), bounds.getHeight() / knobRed.getHeight() * knobRed.getHeight(), Graphics::highResamplingQuality);
-
-        AffineTransform rotator;
-        //if (!slider.isMouseOverOrDragging())
-        //{
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //else
-        //{
-        //    //g.drawImage(knobRed, x, y, width, height, 0, 0, width, height, false);
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //g.drawImageTransformed(knobRed, x, y, width, height, rotator.rotated((float)sliderPosProportional * rotaryEndAngle, (float)(knobRed.getWidth() / 2), (float)(knobRed.getHeight() / 2)), false);
-        //g.drawImage(knobRedRescaled, bounds, RectanglePlacement::stretchToFit, false);
-        int origX = g.getClipBounds().getX();
-        int origY = g.getClipBounds().getY();
-        g.drawImageTransformed(knobRedRescaled, rotator.rotated(sliderAngRad, knobRedRescaled.getWidth() / 2, knobRedRescaled.getHeight() / 2).translated(bounds.getX() - origX, bounds.getY() - origY));
-
-
-        // TRYING TO PUT IMAGE HERE
+        // pre-rendered for this size and angle step, nothing is decoded or rescaled here
+        knobSprites->draw(g, BinaryData::knob_blue_png, BinaryData::knob_blue_pngSize, bounds, sliderPosProportional, rotaryStartAngle, rotaryEndAngle);
 
 
         if (slider.isMouseOverOrDragging())
@@ -233,28 +193,8 @@ void LookAndFeelGreen::drawRotarySlider(juce::Graphics& g, int x, int y, int wid
 
         //g.fillPath(p);
 
-        // TRYING TO PUT IMAGE HERE
-        juce::Image knobRed = ImageCache::getFromMemory(BinaryData::knob_green_png, BinaryData::knob_green_pngSize);
-        juce::Image knobRedRescaled = knobRed.rescaled(bounds.getWidth() / knobRed.getWidth() * knobRed.getWidth(), bounds.getHeight() / knobRed.getHeight() * knobRed.getHeight(), Graphics::highResamplingQuality);
-
-        AffineTransform rotator;
-        //if (!slider.isMouseOverOrDragging())
-        //{
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //else
-        //{
-        //    //g.drawImage(knobRed, x, y, width, height, 0, 0, width, height, false);
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //g.drawImageTransformed(knobRed, x, y, width, height, rotator.rotated((float)sliderPosProportional * rotaryEndAngle, (float)(knobRed.getWidth() / 2), (float)(knobRed.getHeight() / 2)), false);
-        //g.drawImage(knobRedRescaled, bounds, RectanglePlacement::stretchToFit, false);
-        int origX = g.getClipBounds().getX();
-        int origY = g.getClipBounds().getY();
-        g.drawImageTransformed(knobRedRescaled, rotator.rotated(sliderAngRad, knobRedRescaled.getWidth() / 2, knobRedRescaled.getHeight() / 2).translated(bounds.getX() - origX, bounds.getY() - origY));
-
-
-        // TRYING TO PUT IMAGE HERE
+        // pre-rendered for this size and angle step, nothing is decoded or rescaled here
+        knobSprites->draw(g, BinaryData::knob_green_png, BinaryData::knob_green_pngSize, bounds, sliderPosProportional, rotaryStartAngle, rotaryEndAngle);
 
 
         if (slider.isMouseOverOrDragging())
@@ -309,28 +249,8 @@ void LookAndFeelBlack::drawRotarySlider(juce::Graphics& g, int x, int y, int wid
 
         //g.fillPath(p);
 
-        // TRYING TO PUT IMAGE HERE
-        juce::Image knobRed = ImageCache::getFromMemory(BinaryData::knob_black_png, BinaryData::knob_black_pngSize);
-        juce::Image knobRedRescaled = knobRed.rescaled(bounds.getWidth() / knobRed.getWidth() * knobRed.getWidth(), bounds.getHeight() / knobRed.getHeight() * knobRed.getHeight(), Graphics::highResamplingQuality);
-
-        AffineTransform rotator;
-        //if (!slider.isMouseOverOrDragging())
-        //{
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //else
-        //{
-        //    //g.drawImage(knobRed, x, y, width, height, 0, 0, width, height, false);
-        //    g.drawImage(knobRed, bounds, RectanglePlacement::stretchToFit, false);
-        //}
-        //g.drawImageTransformed(knobRed, x, y, width, height, rotator.rotated((float)sliderPosProportional * rotaryEndAngle, (float)(knobRed.getWidth() / 2), (float)(knobRed.getHeight() / 2)), false);
-        //g.drawImage(knobRedRescaled, bounds, RectanglePlacement::stretchToFit, false);
-        int origX = g.getClipBounds().getX();
-        int origY = g.getClipBounds().getY();
-        g.drawImageTransformed(knobRedRescaled, rotator.rotated(sliderAngRad, knobRedRescaled.getWidth() / 2, knobRedRescaled.getHeight() / 2).translated(bounds.getX() - origX, bounds.getY() - origY));
-
-
-        // TRYING TO PUT IMAGE HERE
+        // pre-rendered for this size and angle step, nothing is decoded or rescaled here
+        knobSprites->draw(g, BinaryData::knob_black_png, BinaryData::knob_black_pngSize, bounds, sliderPosProportional, rotaryStartAngle, rotaryEndAngle);
 
 
         if (slider.isMouseOverOrDragging())
@@ -458,9 +378,19 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 
 
 ResponseCurveComponent::ResponseCurveComponent(BasicEQAudioProcessor& p) : audioProcessor(p), //leftChannelFifo(&audioProcessor.leftChannelFifo)
-leftPathProducer(audioProcessor.leftChannelFifo),
-rightPathProducer(audioProcessor.rightChannelFifo)
+analyzer(audioProcessor.leftChannelFifo, audioProcessor.rightChannelFifo)
 {
+    // ids are AnalyzerMode + 1, the choice is saved with the plugin state
+    analyzerModeBox.addItemList({ "L+R", "L", "R", "Mid", "Side", "Max" }, 1);
+    analyzerModeBox.onChange = [this]
+        {
+            const auto newMode = analyzerModeBox.getSelectedId() - 1;
+            analyzer.setMode((AnalyzerMode)newMode);
+            audioProcessor.apvts.state.setProperty("Analyzer Mode", newMode, nullptr);
+        };
+    analyzerModeBox.setSelectedId(juce::jlimit((int)Analyzer_Stereo, (int)Analyzer_Max, (int)audioProcessor.apvts.state.getProperty("Analyzer Mode", (int)Analyzer_Stereo)) + 1);
+    addAndMakeVisible(analyzerModeBox);
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
@@ -469,11 +399,22 @@ rightPathProducer(audioProcessor.rightChannelFifo)
 
     updateChain();
 
+    // the processor only feeds the analyzer fifos while this is registered, the analysis thread reads them
+    audioProcessor.addAnalysisConsumer(Analysis_Spectrum);
+    analyzer.setDrawingArea(getAnalysisArea().toFloat(), audioProcessor.getSampleRate());
+    analysisThread->addTimeSliceClient(&analyzer);
+
+    // fills itself completely, repainting the spectrum doesn't repaint the editor behind it
+    setOpaque(true);
     startTimerHz(60);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    // waits if the analyzer is being run right now
+    analysisThread->removeTimeSliceClient(&analyzer);
+    audioProcessor.removeAnalysisConsumer(Analysis_Spectrum);
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
@@ -487,173 +428,286 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
     parametersChanged.set(true);
 }
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+StereoPathProducer::StereoPathProducer(SampleFifo& left, SampleFifo& right) : fifos{ { &left, &right } }
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
-    // if there is a buffer available in the FIFO, send it to FFT data generator
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+    const auto fftSize = fft.getSize();
+
+    window.resize((size_t)fftSize);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t)fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+
+    timeData.resize((size_t)fftSize);
+    spectrum.resize((size_t)fftSize);
+    incomingSamples.resize((size_t)fftSize);
+    for (auto& channel : history)
+        channel.assign((size_t)fftSize, 0.f);
+    for (auto& data : renderData)
+        data.resize((size_t)fftSize / 2);
+
+    preRoll = fftSize;
+    setOverlap(0.75f);
+}
+
+void StereoPathProducer::setOverlap(float overlap)
+{
+    hopSize = juce::jmax(1, juce::roundToInt((float)fft.getSize() * (1.f - juce::jlimit(0.f, 0.95f, overlap))));
+}
+
+void StereoPathProducer::setDrawingArea(juce::Rectangle<float> fftBounds, double sampleRate)
+{
+    const juce::SpinLock::ScopedLockType sl(areaLock);
+    drawingArea = fftBounds;
+    drawingSampleRate = sampleRate;
+}
+
+int StereoPathProducer::useTimeSlice()
+{
+    juce::Rectangle<float> fftBounds;
+    double sampleRate;
     {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))    // if we can get the buffer
-        {
-            auto size = tempIncomingBuffer.getNumSamples();
-            // this shifts stuff in the buffer by how big the sent out buffer is
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),   // where to copy - to the start of the buffer
-                monoBuffer.getReadPointer(0, size), // source to copy - starts where the previous buffer block ended
-                monoBuffer.getNumSamples() - size); // how many values to copy - all values except the ones in the previous buffer block
-
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),   // copy to the end of the buffer
-                tempIncomingBuffer.getReadPointer(0, 0),                            // copy from start of incoming buffer
-                size);                                                              // copy as many values as are in incoming buffer
-            // block above effectively shifts audio in monoBuffer left by the block size, appending new data from tempIncomingBuffer at the end of monoBuffer //
-
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -92.f); // pass monoBuffer to the FFT, negativeInfinity set to -48dB (what level of audio will be the lowest)
-        }
+        const juce::SpinLock::ScopedLockType sl(areaLock);
+        fftBounds = drawingArea;
+        sampleRate = drawingSampleRate;
     }
 
-    // if there are FFT data buffers to pull, try to pull it and generate path from it
-    // fftBounds is where it should draw the path
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-    const auto binWidth = sampleRate / (double)fftSize; // e.g. 48000 / 2048 = 23 Hz - frequency width of one fft bin, casting fftSize to double because sampleRate is double
+    // both fifos are written by the same processBlock(), taking as many from each keeps them lined up
+    const auto fftSize = fft.getSize();
+    const auto numChannels = mono.load() ? (size_t)1 : (size_t)2;
+    auto available = fifos[0]->getNumSamplesAvailable();
+    if (numChannels > 1)
+        available = juce::jmin(available, fifos[1]->getNumSamplesAvailable());
+    const auto size = juce::jmin(available, fftSize);
 
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    for (size_t ch = 0; ch < numChannels; ++ch)
     {
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
-        {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -92.f);
-        }
+        if (available > fftSize)
+            fifos[ch]->skip(available - fftSize);
+
+        fifos[ch]->pull(incomingSamples.data(), size);
+
+        const auto first = juce::jmin(size, fftSize - historyPosition);
+        juce::FloatVectorOperations::copy(history[ch].data() + historyPosition, incomingSamples.data(), first);
+        juce::FloatVectorOperations::copy(history[ch].data(), incomingSamples.data() + first, size - first);
     }
 
-    // if there are paths that can be pulled, pull as many as possible, display the most recent one
-    while (pathProducer.getNumPathsAvailable())
+    historyPosition = (historyPosition + size) % fftSize;
+    preRoll = juce::jmax(0, preRoll - size);
+
+    // a frame is due every hop. However many came due since the last slice only the newest is computed,
+    // the others would never be drawn. Nothing is drawn until a whole FFT length came in after the editor
+    // opened, a half empty buffer would show as a dip
+    const auto hop = hopSize.load();
+    samplesSinceFrame = juce::jmin(samplesSinceFrame + available, hop);
+
+    if (preRoll == 0 && samplesSinceFrame == hop && !fftBounds.isEmpty() && sampleRate > 0)
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        transform(fftBounds, sampleRate);
+        samplesSinceFrame = 0;
+
+        for (size_t i = 0; i < workFrame.size(); ++i)
+            while (pathGenerators[i].getNumPathsAvailable())
+                pathGenerators[i].getPath(workFrame[i]);
+
+        // the frame that comes back is an old one, overwritten next time
+        mailbox.swapIn(workFrame);
     }
+
+    return AnalysisThread::frameIntervalMs;
 }
 
-void ResponseCurveComponent::timerCallback()
+void StereoPathProducer::transform(juce::Rectangle<float> fftBounds, double sampleRate)
 {
-    auto fftBounds = getAnalysisArea().toFloat();
-    auto sampleRate = audioProcessor.getSampleRate();
+    const auto fftSize = fft.getSize();
+    const auto mask = fftSize - 1;
+    const auto numBins = fftSize / 2;
+    const auto negativeInfinity = -92.f;
+    const auto isMono = mono.load();
+    const auto mode = isMono ? Analyzer_Left : getMode();
+
+    // oldest sample first, windowed, L real and R imaginary (nothing for mono)
+    for (int i = 0; i < fftSize; ++i)
+    {
+        const auto index = (size_t)((historyPosition + i) & mask);
+        timeData[(size_t)i] = { history[0][index] * window[(size_t)i], isMono ? 0.f : history[1][index] * window[(size_t)i] };
+    }
+
+    fft.perform(timeData.data(), spectrum.data(), false);
 
-    leftPathProducer.process(fftBounds, sampleRate);
-    rightPathProducer.process(fftBounds, sampleRate);
+    auto toDecibels = [numBins, negativeInfinity](float magnitude)
+        {
+            return juce::Decibels::gainToDecibels(magnitude / (float)numBins, negativeInfinity);
+        };
 
-    if (parametersChanged.compareAndSetBool(false, true))
+    for (int k = 0; k < numBins; ++k)
+    {
+        // L = (Z[k] + conj(Z[N - k])) / 2, R = (Z[k] - conj(Z[N - k])) / 2j
+        const auto z = spectrum[(size_t)k];
+        const auto mirrored = std::conj(spectrum[(size_t)((fftSize - k) & mask)]);
+        const auto left = 0.5f * (z + mirrored);
+        const auto right = juce::dsp::Complex<float>(0.f, -0.5f) * (z - mirrored);
+
+        switch (mode)
+        {
+        case Analyzer_Stereo:
+            renderData[0][(size_t)k] = toDecibels(std::abs(left));
+            renderData[1][(size_t)k] = toDecibels(std::abs(right));
+            break;
+        case Analyzer_Left:  renderData[0][(size_t)k] = toDecibels(std::abs(left)); break;
+        case Analyzer_Right: renderData[0][(size_t)k] = toDecibels(std::abs(right)); break;
+        case Analyzer_Mid:   renderData[0][(size_t)k] = toDecibels(std::abs(0.5f * (left + right))); break;
+        case Analyzer_Side:  renderData[0][(size_t)k] = toDecibels(std::abs(0.5f * (left - right))); break;
+        case Analyzer_Max:   renderData[0][(size_t)k] = toDecibels(juce::jmax(std::abs(left), std::abs(right))); break;
+        }
+    }
+
+    const auto binWidth = (float)(sampleRate / (double)fftSize);
+    pathGenerators[0].generatePath(renderData[0], fftBounds, fftSize, binWidth, negativeInfinity);
+    if (mode == Analyzer_Stereo)
+        pathGenerators[1].generatePath(renderData[1], fftBounds, fftSize, binWidth, negativeInfinity);
+    else
+        workFrame[1].clear();
+}
+
+void ResponseCurveComponent::timerCallback()
+{
+    // the paths are made on the analysis thread, here they are only picked up
+    analyzer.setDrawingArea(getAnalysisArea().toFloat(), audioProcessor.getSampleRate());
+    analyzer.setMono(audioProcessor.getTotalNumOutputChannels() == 1);
+    auto needsRepaint = analyzer.pullPaths();
+
+    // the curve only changes with the parameters (or the rate the filters are designed for, oversampled or not)
+    const auto sampleRateChanged = getDesignRate() != responseSampleRate;
+    if (parametersChanged.compareAndSetBool(false, true) || sampleRateChanged)
     {
         updateChain();
-        //signal a repaint
-        //repaint();
+        updateResponseCurve();
+        needsRepaint = true;
     }
-    // need to be repainting all the time, not only when a parameter changes
-    repaint();
+
+    if (needsRepaint)
+        repaint();
 }
 
 void ResponseCurveComponent::updateChain()
 {
     //update mono chain
     auto chainSettings = getChainSettings(audioProcessor.apvts);
+    const auto designRate = getDesignRate();
 
     monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
     monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
     monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
 
-    auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
+    auto peakCoefficients = makePeakFilter(chainSettings, designRate);
     updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
 
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
+    auto lowCutCoefficients = makeLowCutFilter(chainSettings, designRate);
+    auto highCutCoefficients = makeHighCutFilter(chainSettings, designRate);
 
     updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
     updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
 }
 
-void ResponseCurveComponent::parameterGestureChanged(int parameterIndex, bool gestureIsStarting) {  };
-
-void ResponseCurveComponent::paint(juce::Graphics& g)
+double ResponseCurveComponent::getDesignRate() const
 {
-    using namespace juce;
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll(Colours::black);
-
-    g.drawImage(background, getLocalBounds().toFloat());
+    return audioProcessor.getSampleRate() * audioProcessor.getEqOversamplingFactor();
+}
 
+void ResponseCurveComponent::updateResponseCurve()
+{
+    // the active EQ at one frequency per pixel column, then cached as a path for paint()
     auto responseArea = getLocalBounds();
+    responseSampleRate = getDesignRate();
+    magnitudeResponse.prepare(responseArea.getWidth(), responseSampleRate);
+    magnitudeResponse.reset();
 
-    auto w = responseArea.getWidth();
-
-    auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highcut = monoChain.get<ChainPositions::HighCut>();
-
-    auto sampleRate = audioProcessor.getSampleRate();
-
-    std::vector<double> mags;
-
-    mags.resize(w);
-
-    for (int i = 0; i < w; ++i)
+    // the FIR modes don't run these biquads, they are designed from the analog prototypes that don't cramp towards Nyquist
+    const auto eqMode = (int)audioProcessor.apvts.getRawParameterValue("EQ Mode")->load();
+    if (eqMode == EqMode_LinearPhase || eqMode == EqMode_MinimumPhase)
     {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+        const auto chainSettings = getChainSettings(audioProcessor.apvts);
+        magnitudeResponse.addMagnitude([&chainSettings](double frequency) { return EqKernelDesigner::getTargetMagnitude(chainSettings, frequency); });
+    }
+    else
+    {
+        auto& lowcut = monoChain.get<ChainPositions::LowCut>();
+        auto& peak = monoChain.get<ChainPositions::Peak>();
+        auto& highcut = monoChain.get<ChainPositions::HighCut>();
 
         if (!monoChain.isBypassed<ChainPositions::Peak>())
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+            magnitudeResponse.addBiquad(*peak.coefficients);
 
         if (!monoChain.isBypassed<ChainPositions::LowCut>())
         {
             if (!lowcut.isBypassed<0>())
-                mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*lowcut.get<0>().coefficients);
             if (!lowcut.isBypassed<1>())
-                mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*lowcut.get<1>().coefficients);
             if (!lowcut.isBypassed<2>())
-                mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*lowcut.get<2>().coefficients);
             if (!lowcut.isBypassed<3>())
-                mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*lowcut.get<3>().coefficients);
         }
         if (!monoChain.isBypassed<ChainPositions::HighCut>())
         {
             if (!highcut.isBypassed<0>())
-                mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*highcut.get<0>().coefficients);
             if (!highcut.isBypassed<1>())
-                mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*highcut.get<1>().coefficients);
             if (!highcut.isBypassed<2>())
-                mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*highcut.get<2>().coefficients);
             if (!highcut.isBypassed<3>())
-                mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+                magnitudeResponse.addBiquad(*highcut.get<3>().coefficients);
         }
-        mags[i] = Decibels::gainToDecibels(mag);
     }
 
-    Path filterResponseCurve;
-
     const double outputMin = responseArea.getBottom()-10;
     const double outputMax = responseArea.getY();
     auto map = [outputMin, outputMax](double input)
         {
-            return jmap(input, -24.0, 24.0, outputMin, outputMax);
+            return juce::jmap(input, -24.0, 24.0, outputMin, outputMax);
         };
 
-    filterResponseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+    responseCurve.clear();
+    if (magnitudeResponse.getNumPoints() == 0)
+        return;
 
-    for (size_t i = 1; i < mags.size(); ++i)
+    responseCurve.startNewSubPath(responseArea.getX(), map(magnitudeResponse.getDecibels(0)));
+
+    for (int i = 1; i < magnitudeResponse.getNumPoints(); ++i)
     {
-        filterResponseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+        responseCurve.lineTo(responseArea.getX() + i, map(magnitudeResponse.getDecibels(i)));
     }
+}
 
-    auto leftChannelFFTPath = leftPathProducer.getPath();
-    auto rightChannelFFTPath = rightPathProducer.getPath();
+void ResponseCurveComponent::parameterGestureChanged(int parameterIndex, bool gestureIsStarting) {  };
 
-    leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-    rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
-    g.setColour(Colours::lawngreen);
-    g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
+void ResponseCurveComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    g.fillAll(Colours::black);
+
+    g.drawImageAt(background, 0, 0);
 
-    g.setColour(Colours::orangered);
-    g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+    auto responseArea = getLocalBounds();
+
+    // L (or the only path) green, R orange, mid/side/max get their own colour
+    const auto mode = analyzer.getMode();
+    auto analyzerPath = analyzer.getPath(0);
+    analyzerPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+    g.setColour(mode == Analyzer_Stereo || mode == Analyzer_Left ? Colours::lawngreen : mode == Analyzer_Right ? Colours::orangered : Colours::deepskyblue);
+    g.strokePath(analyzerPath, PathStrokeType(1.f));
+
+    if (mode == Analyzer_Stereo)
+    {
+        auto rightChannelFFTPath = analyzer.getPath(1);
+        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+        g.setColour(Colours::orangered);
+        g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+    }
 
     g.setColour(Colours::white);
-    g.strokePath(filterResponseCurve, PathStrokeType(2.f));
+    g.strokePath(responseCurve, PathStrokeType(2.f));
     
     g.setColour(Colours::silver);
     g.drawRoundedRectangle(responseArea.toFloat(), 6.f, 5.f);
@@ -661,6 +715,8 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 
 void ResponseCurveComponent::resized()
 {
+    analyzerModeBox.setBounds(6, 6, 64, 20);
+    updateResponseCurve();
 
     // drawing frequency grid behind EQ response graph
     using namespace juce;
@@ -714,19 +770,26 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
     return bounds;
 }
 
-IrFFTComponent::IrFFTComponent(BasicEQAudioProcessor& p) : audioProcessor(p), 
-leftPathProducer(audioProcessor.leftChannelFifo),
-rightPathProducer(audioProcessor.rightChannelFifo)
+IrFFTComponent::IrFFTComponent(BasicEQAudioProcessor& p) : audioProcessor(p)
 {
     /*const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
         param->addListener(this);
     }*/
+
+    irFFTDataGenerator.changeOrder(FFTOrder::order16384);
+    irBuffer.setSize(1, irFFTDataGenerator.getFFTSize());
+    analysisThread->addTimeSliceClient(this);
+
+    setOpaque(true);
 }
 
 IrFFTComponent::~IrFFTComponent()
 {
+    analysisThread->removeTimeSliceClient(this);
+    cancelPendingUpdate();
+
     /*const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
@@ -735,63 +798,71 @@ IrFFTComponent::~IrFFTComponent()
 }
 
 
-// when we change the IR in onChange lambdas of UI elements, we need to:
-// call this function
-// pass it the selected IR wav file
-// convert wav to vector of floats - currently in AudioBuffer which is pretty much the same, have to see if it will go into FFT or not
-// compute FFT
-// store FFT data into a path
-// call repaint
-void IrFFTComponent::loadedIRChanged(juce::File newIR)
+// when the loaded IR changes, the editor calls this with the new one. It is decoded already, so nothing is
+// read from disk. The FFT and path are made on the analysis thread, handleAsyncUpdate() picks the path up
+void IrFFTComponent::loadedIRChanged(std::shared_ptr<const ImpulseResponse> newIR)
 {
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
+    // effective length after the tail was cut
+    irLengthText = juce::String(1000.0 * newIR->buffer.getNumSamples() / newIR->sampleRate, 1) + " ms";
 
-    if (!newIR.existsAsFile()) { /*DBG("loadedIRChanged: loaded file is not a file");*/ return; }
+    {
+        const juce::SpinLock::ScopedLockType sl(pendingLock);
+        pendingIR = std::move(newIR);
+        pendingArea = getAnalysisArea().toFloat();
+    }
+
+    analysisThread->moveToFrontOfQueue(this);
+    repaint();
+}
 
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(newIR));
-    if (reader.get() == nullptr) { /*DBG("loadedIRChanged: nullptr in reader");*/ return; }
+int IrFFTComponent::useTimeSlice()
+{
+    std::shared_ptr<const ImpulseResponse> ir;
+    juce::Rectangle<float> fftBounds;
+    {
+        const juce::SpinLock::ScopedLockType sl(pendingLock);
+        ir = std::move(pendingIR);
+        fftBounds = pendingArea;
+    }
 
-    leftPathProducer.leftChannelFFTDataGenerator.changeOrder(FFTOrder::order16384);
+    if (ir == nullptr)
+        return AnalysisThread::frameIntervalMs;
 
-    auto fileSampleRate = reader->sampleRate;
-    auto lengthInSamples = reader->lengthInSamples;
-    auto fftBounds = getAnalysisArea().toFloat();
-    const auto fftSize = leftPathProducer.leftChannelFFTDataGenerator.getFFTSize();
-    const auto binWidth = fileSampleRate / (double)fftSize; // e.g. 48000 / 2048 = 23 Hz - frequency width of one fft bin, casting fftSize to double because sampleRate is double
+    const auto fftSize = irFFTDataGenerator.getFFTSize();
+    const auto binWidth = ir->sampleRate / (double)fftSize; // e.g. 48000 / 2048 = 23 Hz - frequency width of one fft bin, casting fftSize to double because sampleRate is double
 
-    // 
-    //juce::AudioBuffer<float> audioBuffer(reader->numChannels, lengthInSamples);
-    //reader->read(&audioBuffer, 0, 8192, 0, true, true); // reader should return zeros if the file it reads is shorter than 4096 samples, this size must be 2 * FFT size
-    
     // THIS IS FOR LEFT CH ONLY
-    juce::AudioBuffer<float> audioBuffer(1, fftSize); // allocate buffer for 1 channel with how many samples are needed for FFT
-    reader->read(&audioBuffer, 0, fftSize, 0, true, false);
-    
-    //fft.performFrequencyOnlyForwardTransform(audioBuffer.getWritePointer(Channel::Left), false);
+    irBuffer.clear();                               // IR shorter than the FFT is zero padded
+    irBuffer.copyFrom(0, 0, ir->buffer, 0, 0, juce::jmin(fftSize, ir->buffer.getNumSamples()));
+    irBuffer.applyGain(1.f / ir->normalisationGain); // draw the IR at the level of the file, not the normalised one
 
-    leftPathProducer.leftChannelFFTDataGenerator.produceFFTDataForRendering(audioBuffer, - 130.f);
+    irFFTDataGenerator.produceFFTDataForRendering(irBuffer, - 130.f);
 
-    // if there are FFT data buffers to pull, try to pull it and generate path from it
     // fftBounds is where it should draw the path
-    
-
-    while (leftPathProducer.leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    while (irFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
     {
-        std::vector<float> fftData;
-        if (leftPathProducer.leftChannelFFTDataGenerator.getFFTData(fftData))
+        if (irFFTDataGenerator.getFFTData(fftData))
         {
-            leftPathProducer.pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, - 90.f);
+            irPathGenerator.generatePath(fftData, fftBounds, fftSize, binWidth, - 90.f);
         }
     }
 
-    // if there are paths that can be pulled, pull as many as possible, display the most recent one
-    while (leftPathProducer.pathProducer.getNumPathsAvailable())
+    // display the most recent path
+    while (irPathGenerator.getNumPathsAvailable())
     {
-        leftPathProducer.pathProducer.getPath(leftPathProducer.leftChannelFFTPath);
+        irPathGenerator.getPath(workPath);
     }
 
-    repaint();
+    pathMailbox.swapIn(workPath);
+    triggerAsyncUpdate();
+
+    return AnalysisThread::frameIntervalMs;
+}
+
+void IrFFTComponent::handleAsyncUpdate()
+{
+    if (pathMailbox.swapOut(irPath))
+        repaint();
 }
 
 void IrFFTComponent::paint(juce::Graphics& g)
@@ -799,14 +870,14 @@ void IrFFTComponent::paint(juce::Graphics& g)
     using namespace juce;
     g.fillAll(Colours::black);
 
-    g.drawImage(background, getLocalBounds().toFloat());
+    g.drawImageAt(background, 0, 0);
 
     auto irArea = getLocalBounds();
 
    
 
     // here we need to paint the path from FFT values
-    auto leftChannelFFTPath = leftPathProducer.getPath();
+    auto leftChannelFFTPath = irPath;
     //auto rightChannelFFTPath = rightPathProducer.getPath();
 
     leftChannelFFTPath.applyTransform(AffineTransform().translation(irArea.getX(), irArea.getY()-80));
@@ -814,6 +885,10 @@ void IrFFTComponent::paint(juce::Graphics& g)
     g.setColour(Colours::white);
     g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
 
+    g.setColour(Colours::lightgrey);
+    g.setFont(12.f);
+    g.drawText(irLengthText, irArea.reduced(10, 6), Justification::topRight);
+
     g.setColour(Colours::silver);
     g.drawRoundedRectangle(irArea.toFloat(), 6.f, 5.f);
 
@@ -885,6 +960,8 @@ highCutFreqSlider(*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
 highCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "dB/Oct"),
 xPosSlider(*audioProcessor.apvts.getParameter("X Position"), "cm"),
 yPosSlider(*audioProcessor.apvts.getParameter("Y Position"), "cm"),
+xDistanceSlider(*audioProcessor.apvts.getParameter("X Distance"), "cm"),
+yDistanceSlider(*audioProcessor.apvts.getParameter("Y Distance"), "cm"),
 outputGainSlider(*audioProcessor.apvts.getParameter("Output Gain"), "dB"),
 responseCurveComponent(audioProcessor),
 irfftComponent(audioProcessor),
@@ -897,11 +974,14 @@ highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSli
 highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider),
 xPosSliderAttachment(audioProcessor.apvts, "X Position", xPosSlider),
 yPosSliderAttachment(audioProcessor.apvts, "Y Position", yPosSlider),
+xDistanceSliderAttachment(audioProcessor.apvts, "X Distance", xDistanceSlider),
+yDistanceSliderAttachment(audioProcessor.apvts, "Y Distance", yDistanceSlider),
 outputGainSliderAttachment(audioProcessor.apvts, "Output Gain", outputGainSlider),
 lowCutBypassButtonAttachment(audioProcessor.apvts, "LowCut Bypassed", lowCutBypassButton),
 highCutBypassButtonAttachment(audioProcessor.apvts, "HighCut Bypassed", highCutBypassButton),
 peakBypassButtonAttachment(audioProcessor.apvts, "Peak Bypassed", peakBypassButton),
-irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton)
+irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton),
+interpolationButtonAttachment(audioProcessor.apvts, "Position Interpolation", interpolationButton)
 
 {
     // Make sure that before the constructor has finished, you've set the
@@ -925,6 +1005,10 @@ irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton)
     xPosSlider.labels.add({ 1.f, "8cm" });
     yPosSlider.labels.add({ 0.f, "0cm" });
     yPosSlider.labels.add({ 1.f, "40cm" });
+    xDistanceSlider.labels.add({ 0.f, "0cm" });
+    xDistanceSlider.labels.add({ 1.f, "8cm" });
+    yDistanceSlider.labels.add({ 0.f, "0cm" });
+    yDistanceSlider.labels.add({ 1.f, "40cm" });
 
     for (auto* comp : getComps())
     {
@@ -944,17 +1028,20 @@ irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton)
     peakQualitySlider.setLookAndFeel(&lnfg);
     xPosSlider.setLookAndFeel(&lnfk);
     yPosSlider.setLookAndFeel(&lnfk);
+    xDistanceSlider.setLookAndFeel(&lnfk);
+    yDistanceSlider.setLookAndFeel(&lnfk);
     outputGainSlider.setLookAndFeel(&lnfk);
 
+    interpolationButton.setButtonText("blend");
+    updatePositionSliders();
+
     comboTypeBox.addItem("Mar", 1);
     comboTypeBox.addItem("MM", 2);
     comboTypeBox.addItem("SV", 3);
     comboTypeBox.setSelectedId(1);
     comboTypeBox.onChange = [this]() { 
         //DBG("changed combo"); 
-        juce::File newIR = audioProcessor.updateLoadedIR(comboTypeBox.getSelectedId() - 1, mikTypeBox.getSelectedId() - 1, yPosSlider.getValue(), xPosSlider.getValue()); 
-        userIRLoaded = false; 
-        irfftComponent.loadedIRChanged(newIR);
+        loadSelectedIR();
         };
 
     mikTypeBox.addItem("57A", 1);
@@ -963,22 +1050,16 @@ irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton)
     mikTypeBox.setSelectedId(1);
     mikTypeBox.onChange = [this]() { 
         //DBG("changed mic"); 
-        juce::File newIR = audioProcessor.updateLoadedIR(comboTypeBox.getSelectedId()-1, mikTypeBox.getSelectedId()-1, yPosSlider.getValue(), xPosSlider.getValue());
-        userIRLoaded = false;
-        irfftComponent.loadedIRChanged(newIR);
+        loadSelectedIR();
         };
 
     yPosSlider.onValueChange = [this]() { 
         //DBG("changed yPos to " << yPosSlider.getValue());
-        juce::File newIR = audioProcessor.updateLoadedIR(comboTypeBox.getSelectedId() - 1, mikTypeBox.getSelectedId() - 1, yPosSlider.getValue(), xPosSlider.getValue());
-        userIRLoaded = false;
-        irfftComponent.loadedIRChanged(newIR);
+        loadSelectedIR();
         };
     xPosSlider.onValueChange = [this]() { 
         //DBG("changed xPos to " << xPosSlider.getValue());
-        juce::File newIR = audioProcessor.updateLoadedIR(comboTypeBox.getSelectedId() - 1, mikTypeBox.getSelectedId() - 1, yPosSlider.getValue(), xPosSlider.getValue());
-        userIRLoaded = false;
-        irfftComponent.loadedIRChanged(newIR);
+        loadSelectedIR();
         };
 
     loadBtn.setButtonText("Load IR");
@@ -997,10 +1078,7 @@ irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton)
                     audioProcessor.savedFile = result;
                     audioProcessor.root = result.getParentDirectory().getFullPathName();    // set root directory to where the file was selected from
                     irNameLabel.setText( result.getFileNameWithoutExtension(), juce::dontSendNotification );
-                    audioProcessor.irLoader.reset();
-                    // load IR, stereo, trimmed, normalized, size 0 = original IR size
-                    audioProcessor.irLoader.loadImpulseResponse(result, juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::yes, 0, juce::dsp::Convolution::Normalise::yes);
-                    irfftComponent.loadedIRChanged(result);
+                    audioProcessor.loadUserImpulseResponse(result);
                 });
             userIRLoaded = true;
             //DBG("loaded ir " << (int)userIRLoaded.compareAndSetBool(true, true) << "with length " << audioProcessor.irLoader.getCurrentIRSize());
@@ -1010,11 +1088,23 @@ irBypassButtonAttachment(audioProcessor.apvts, "IR Bypassed", irBypassButton)
 
     setSize (800, 600);
 
+    loudnessLabel.setJustificationType(juce::Justification::centred);
+    loudnessLabel.setFont(12.f);
+    loudnessLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+
+    audioProcessor.addAnalysisConsumer(Analysis_Meters);
+
+    // IRs may have been installed since the catalogue looked, it looks again on its own thread
+    audioProcessor.irCatalogue->rescan();
+
+    setOpaque(true);
     startTimerHz(30);
 }
 
 BasicEQAudioProcessorEditor::~BasicEQAudioProcessorEditor()
 {
+    audioProcessor.removeAnalysisConsumer(Analysis_Meters);
+
     lowCutBypassButton.setLookAndFeel(nullptr);
     highCutBypassButton.setLookAndFeel(nullptr);
     peakBypassButton.setLookAndFeel(nullptr);
@@ -1027,6 +1117,8 @@ BasicEQAudioProcessorEditor::~BasicEQAudioProcessorEditor()
     peakQualitySlider.setLookAndFeel(nullptr);
     xPosSlider.setLookAndFeel(nullptr);
     yPosSlider.setLookAndFeel(nullptr);
+    xDistanceSlider.setLookAndFeel(nullptr);
+    yDistanceSlider.setLookAndFeel(nullptr);
     irBypassButton.setLookAndFeel(nullptr);
     outputGainSlider.setLookAndFeel(nullptr);
 }
@@ -1034,10 +1126,29 @@ BasicEQAudioProcessorEditor::~BasicEQAudioProcessorEditor()
 //==============================================================================
 void BasicEQAudioProcessorEditor::timerCallback()
 {
-    meterLeft.setLevel(audioProcessor.getRMSValue(0));
-    meterRight.setLevel(audioProcessor.getRMSValue(1));
-    meterLeft.repaint();
-    meterRight.repaint();
+    // the meters repaint themselves, only when the bar moves
+    if (audioProcessor.pullMeterSnapshot(meterSnapshot))
+    {
+        meterLeft.setLevel(meterSnapshot.rmsDb[0], meterSnapshot.truePeakDb[0]);
+        meterRight.setLevel(meterSnapshot.rmsDb[1], meterSnapshot.truePeakDb[1]);
+
+        auto lufs = [](float value) { return value > -99.f ? juce::String(value, 1) : juce::String("-inf"); };
+        loudnessLabel.setText("M " + lufs(meterSnapshot.momentaryLufs) + "  S " + lufs(meterSnapshot.shortTermLufs)
+                              + "  I " + lufs(meterSnapshot.integratedLufs) + " LUFS   TP " + lufs(meterSnapshot.maxTruePeakDb) + " dBTP",
+                              juce::dontSendNotification);
+    }
+
+    // the IR display follows whatever the processor loaded, blends finish in the background
+    auto loadedIR = audioProcessor.getLoadedIR();
+    if (loadedIR != nullptr && loadedIR != drawnIR)
+    {
+        drawnIR = loadedIR;
+        irfftComponent.loadedIRChanged(loadedIR);
+    }
+
+    // the host can switch interpolation too
+    if (xDistanceSlider.isVisible() != interpolationButton.getToggleState())
+        updatePositionSliders();
 }
 
 void BasicEQAudioProcessorEditor::paint (juce::Graphics& g)
@@ -1045,8 +1156,8 @@ void BasicEQAudioProcessorEditor::paint (juce::Graphics& g)
     using namespace juce;
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     //g.fillAll (Colours::black);
-    backgroundImage = ImageCache::getFromMemory(BinaryData::darkbrushedmetaltexturesteelblackstockphotoscratchwallpaper_png, BinaryData::darkbrushedmetaltexturesteelblackstockphotoscratchwallpaper_pngSize);
-    g.drawImage(backgroundImage, getLocalBounds().toFloat(), RectanglePlacement::stretchToFit);
+    // scaled once in resized(), the children on top are opaque or small so this is rarely drawn
+    g.drawImageAt(backgroundImage, 0, 0);
 }
 
 void BasicEQAudioProcessorEditor::resized()
@@ -1055,6 +1166,9 @@ void BasicEQAudioProcessorEditor::resized()
     // subcomponents in your editor..
 
     auto bounds = getLocalBounds();
+    backgroundImage = juce::ImageCache::getFromMemory(BinaryData::darkbrushedmetaltexturesteelblackstockphotoscratchwallpaper_png, BinaryData::darkbrushedmetaltexturesteelblackstockphotoscratchwallpaper_pngSize)
+        .rescaled(juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), juce::Graphics::highResamplingQuality);
+
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
 
     auto responseCurveComponentBounds = responseArea.removeFromRight(responseArea.getWidth() * 0.5);
@@ -1067,6 +1181,8 @@ void BasicEQAudioProcessorEditor::resized()
     IRSlidersArea.removeFromBottom(IRSlidersArea.getHeight() * 0.4);
     xPosSlider.setBounds(IRSlidersArea.removeFromRight(IRSlidersArea.getWidth() * 0.5));
     yPosSlider.setBounds(IRSlidersArea);
+    xDistanceSlider.setBounds(xPosSlider.getBounds());
+    yDistanceSlider.setBounds(yPosSlider.getBounds());
 
     auto comboBoxArea = IRArea;
     auto mikBoxArea = IRArea;
@@ -1084,7 +1200,7 @@ void BasicEQAudioProcessorEditor::resized()
     mikTypeBox.setBounds(mikBoxArea);
 
     irBypassButtonArea.reduce(irBypassButtonArea.getWidth() * 0.37, irBypassButtonArea.getHeight() * 0.15);
-    irBypassButtonArea.removeFromTop(irBypassButtonArea.getHeight() * 0.55);
+    interpolationButton.setBounds(irBypassButtonArea.removeFromTop(irBypassButtonArea.getHeight() * 0.55).removeFromBottom(24));
     irBypassButton.setBounds(irBypassButtonArea);
 
     auto IrFFTComponentBounds = responseArea;
@@ -1139,7 +1255,25 @@ void BasicEQAudioProcessorEditor::resized()
 
     meterLeft.setBounds(meterLeftArea);
     meterRight.setBounds(meterRightArea);
+    loudnessLabel.setBounds(meterLeftArea.getUnion(meterRightArea).withHeight(16).translated(0, meterLeftArea.getHeight() + 4));
+
+}
 
+void BasicEQAudioProcessorEditor::loadSelectedIR()
+{
+    // timerCallback() draws it once the processor has it
+    audioProcessor.updateLoadedIR(comboTypeBox.getSelectedId() - 1, mikTypeBox.getSelectedId() - 1, yPosSlider.getValue(), xPosSlider.getValue());
+    userIRLoaded = false;
+}
+
+void BasicEQAudioProcessorEditor::updatePositionSliders()
+{
+    // stepped X/Y Position or the continuous distances, both sit in the same place
+    const auto interpolating = interpolationButton.getToggleState();
+    xPosSlider.setVisible(!interpolating);
+    yPosSlider.setVisible(!interpolating);
+    xDistanceSlider.setVisible(interpolating);
+    yDistanceSlider.setVisible(interpolating);
 }
 
 std::vector<juce::Component*> BasicEQAudioProcessorEditor::getComps()
@@ -1159,6 +1293,9 @@ std::vector<juce::Component*> BasicEQAudioProcessorEditor::getComps()
         &irNameLabel,
         &xPosSlider,
         &yPosSlider,
+        &xDistanceSlider,
+        &yDistanceSlider,
+        &interpolationButton,
         &comboTypeBox,
         &mikTypeBox,
         &lowCutBypassButton,
@@ -1167,7 +1304,8 @@ std::vector<juce::Component*> BasicEQAudioProcessorEditor::getComps()
         &irBypassButton,
         &outputGainSlider,
         &meterLeft,
-        &meterRight
+        &meterRight,
+        &loudnessLabel
     };
 }
 
@@ -11,6 +11,9 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "HorizontalMeter.h"
+#include "AnalysisThread.h"
+#include "MagnitudeResponse.h"
+#include "KnobSprites.h"
 
 enum FFTOrder
 {
@@ -34,6 +37,52 @@ struct FFTDataGenerator
         auto* readIndex = audioData.getReadPointer(0);
         std::copy(readIndex, readIndex + fftSize, fftData.begin());
 
+        transformAndPush(negativeInfinity);
+    }
+
+    /**
+     same for a circular buffer of getFFTSize() samples, 'oldest' is the index of its oldest sample
+     */
+    void produceFFTDataForRendering(const float* circularData, int oldest, const float negativeInfinity)
+    {
+        const auto fftSize = getFFTSize();
+        jassert(oldest >= 0 && oldest < fftSize);
+
+        fftData.assign(fftData.size(), 0);
+        std::copy(circularData + oldest, circularData + fftSize, fftData.begin());
+        std::copy(circularData, circularData + oldest, fftData.begin() + (fftSize - oldest));
+
+        transformAndPush(negativeInfinity);
+    }
+
+    void changeOrder(FFTOrder newOrder)
+    {
+        //when you change order, recreate the window, forwardFFT, fifo, fftData
+        //also reset the fifoIndex
+        //things that need recreating should be created on the heap via std::make_unique<>
+
+        order = newOrder;
+        auto fftSize = getFFTSize();
+
+        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
+        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+
+        fftData.clear();
+        fftData.resize(fftSize * 2, 0);
+
+        fftDataFifo.prepare(fftData.size());
+    }
+    //==============================================================================
+    int getFFTSize() const { return 1 << order; }
+    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
+    //==============================================================================
+    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+private:
+    // fftData holds one FFT length of samples
+    void transformAndPush(const float negativeInfinity)
+    {
+        const auto fftSize = getFFTSize();
+
         // first apply a windowing function to our data
         window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
 
@@ -67,29 +116,6 @@ struct FFTDataGenerator
         fftDataFifo.push(fftData);
     }
 
-    void changeOrder(FFTOrder newOrder)
-    {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
-
-        order = newOrder;
-        auto fftSize = getFFTSize();
-
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
-
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-
-        fftDataFifo.prepare(fftData.size());
-    }
-    //==============================================================================
-    int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
-    //==============================================================================
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
-private:
     FFTOrder order;
     BlockType fftData;
     std::unique_ptr<juce::dsp::FFT> forwardFFT;
@@ -180,6 +206,8 @@ struct LookAndFeel : juce::LookAndFeel_V4
                             juce::ToggleButton& toggleButton,
                             bool shouldDrawButtonAsHighlighted,
                             bool shouldDrawButtonAsDown) override;
+private:
+    juce::SharedResourcePointer<KnobSprites> knobSprites;
 };
 
 struct LookAndFeelBlue : juce::LookAndFeel_V4
@@ -190,6 +218,8 @@ struct LookAndFeelBlue : juce::LookAndFeel_V4
         float rotaryStartAngle,
         float rotaryEndAngle,
         juce::Slider&) override;
+private:
+    juce::SharedResourcePointer<KnobSprites> knobSprites;
 };
 
 struct LookAndFeelGreen : juce::LookAndFeel_V4
@@ -200,6 +230,8 @@ struct LookAndFeelGreen : juce::LookAndFeel_V4
         float rotaryStartAngle,
         float rotaryEndAngle,
         juce::Slider&) override;
+private:
+    juce::SharedResourcePointer<KnobSprites> knobSprites;
 };
 
 struct LookAndFeelBlack : juce::LookAndFeel_V4
@@ -210,6 +242,8 @@ struct LookAndFeelBlack : juce::LookAndFeel_V4
         float rotaryStartAngle,
         float rotaryEndAngle,
         juce::Slider&) override;
+private:
+    juce::SharedResourcePointer<KnobSprites> knobSprites;
 };
 
 struct RotarySliderWithLabels : juce::Slider
@@ -250,33 +284,74 @@ private:
     juce::String suffix;
 };
 
-struct PathProducer
+enum AnalyzerMode
 {
-    PathProducer(SingleChannelSampleFifo<BasicEQAudioProcessor::BlockType>& scsf) : 
-    leftChannelFifo(&scsf) 
-    {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order4096); // init FFT with set order
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());  // init mono buffer with 1 channel and as many samples as DataGenerator uses
-    }
+    Analyzer_Stereo,    // L and R, both drawn
+    Analyzer_Left,
+    Analyzer_Right,
+    Analyzer_Mid,
+    Analyzer_Side,
+    Analyzer_Max        // the louder of L and R in every bin
+};
 
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return leftChannelFFTPath; }
-    
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+/**
+ spectrum of both analyzer fifos from one complex FFT: L goes into the real part, R into the imaginary part,
+ and the two spectra are separated again afterwards, since the spectrum of a real signal is conjugate symmetric.
+ Mid and side are linear in L and R, so they come out of the same transform.
+ Runs on the AnalysisThread: the newest FFT length of samples is kept in a circular history, a frame is due
+ every hop (set by the overlap, not by the host block size) and however many came due since the last time slice
+ only the newest one is transformed. Finished paths are handed to the message thread through a TripleBuffer.
+ */
+struct StereoPathProducer : juce::TimeSliceClient
+{
+    using SampleFifo = SingleChannelSampleFifo<BasicEQAudioProcessor::BlockType>;
 
-    juce::Path leftChannelFFTPath;
+    StereoPathProducer(SampleFifo& left, SampleFifo& right);
 
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+    // message thread, used from the next frame on
+    void setOverlap(float overlap);
+    void setMode(AnalyzerMode newMode) { mode = newMode; }
+    AnalyzerMode getMode() const { return (AnalyzerMode)mode.load(); }
+    // a mono processor only feeds the left fifo, there is one path then whatever the mode
+    void setMono(bool isMono) { mono = isMono; }
+    void setDrawingArea(juce::Rectangle<float> fftBounds, double sampleRate);
 
+    // message thread, takes the newest paths. False if there was nothing new since the last call
+    bool pullPaths() { return mailbox.swapOut(paths); }
+    // path 1 is R, only used in Analyzer_Stereo. Path 0 is everything else
+    juce::Path getPath(int index) const { return paths[(size_t)index]; }
+
+    // analysis thread, at most one FFT per call
+    int useTimeSlice() override;
 private:
-    SingleChannelSampleFifo<BasicEQAudioProcessor::BlockType>* leftChannelFifo;
+    using Frame = std::array<juce::Path, 2>;
 
-    juce::AudioBuffer<float> monoBuffer;
+    void transform(juce::Rectangle<float> fftBounds, double sampleRate);
 
+    std::array<SampleFifo*, 2> fifos;
+    std::atomic<int> mode{ Analyzer_Stereo };
+    std::atomic<bool> mono{ false };
 
-    
+    juce::SpinLock areaLock;
+    juce::Rectangle<float> drawingArea;
+    double drawingSampleRate = 44100.0;
 
-    
+    juce::dsp::FFT fft{ FFTOrder::order4096 };
+    std::vector<float> window;
+    std::vector<juce::dsp::Complex<float>> timeData, spectrum;
+
+    std::array<std::vector<float>, 2> history;       // circular, both channels share the position
+    int historyPosition = 0;
+    std::vector<float> incomingSamples;
+    int preRoll = 0;
+    std::atomic<int> hopSize{ 1 };
+    int samplesSinceFrame = 0;
+
+    std::array<std::vector<float>, 2> renderData;    // dB per bin
+    std::array<AnalyzerPathGenerator<juce::Path>, 2> pathGenerators;
+    Frame workFrame;                                 // analysis thread
+    TripleBuffer<Frame> mailbox;
+    Frame paths;                                     // message thread
 };
 
 struct ResponseCurveComponent : juce::Component,
@@ -313,16 +388,27 @@ private:
     MonoChain monoChain;
 
     void updateChain();
+    void updateResponseCurve();
+    double getDesignRate() const;
+
+    // recomputed when a parameter, the size or the sample rate changes, paint() only strokes it
+    MagnitudeResponse magnitudeResponse;
+    juce::Path responseCurve;
+    double responseSampleRate = 0;
 
     juce::Image background;
     
-    PathProducer leftPathProducer, rightPathProducer;
+    juce::SharedResourcePointer<AnalysisThread> analysisThread;
+    StereoPathProducer analyzer;
+    juce::ComboBox analyzerModeBox;
 
     juce::Rectangle<int> getRenderArea();
     juce::Rectangle<int> getAnalysisArea();
 };
 
-struct IrFFTComponent : juce::Component/*,
+struct IrFFTComponent : juce::Component,
+    juce::TimeSliceClient,
+    juce::AsyncUpdater/*,
     juce::AudioProcessorParameter::Listener*/
 {
     IrFFTComponent(BasicEQAudioProcessor&);
@@ -330,9 +416,13 @@ struct IrFFTComponent : juce::Component/*,
 
     /*void parameterValueChanged(int parameterIndex, float newValue) override;
     void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;*/
-    void loadedIRChanged(juce::File newIR);
+    // message thread, the spectrum is made on the AnalysisThread and drawn when it is done
+    void loadedIRChanged(std::shared_ptr<const ImpulseResponse> newIR);
     void paint(juce::Graphics& g) override;
     void resized() override;
+
+    int useTimeSlice() override;
+    void handleAsyncUpdate() override;
 private:
     BasicEQAudioProcessor& audioProcessor;
     juce::Atomic<bool> parametersChanged{ false };
@@ -341,7 +431,22 @@ private:
     juce::Image background;
 
     juce::dsp::FFT fft{ FFTOrder::order4096 };
-    PathProducer leftPathProducer, rightPathProducer;
+    juce::String irLengthText;
+
+    juce::SharedResourcePointer<AnalysisThread> analysisThread;
+    juce::SpinLock pendingLock;
+    std::shared_ptr<const ImpulseResponse> pendingIR;
+    juce::Rectangle<float> pendingArea;
+
+    // analysis thread
+    FFTDataGenerator<std::vector<float>> irFFTDataGenerator;
+    AnalyzerPathGenerator<juce::Path> irPathGenerator;
+    juce::AudioBuffer<float> irBuffer;
+    std::vector<float> fftData;
+    juce::Path workPath;
+
+    TripleBuffer<juce::Path> pathMailbox;
+    juce::Path irPath;  // message thread
 
     juce::Rectangle<int> getRenderArea();
     juce::Rectangle<int> getAnalysisArea();
@@ -366,18 +471,22 @@ private:
     // access the processor object that created it.
     BasicEQAudioProcessor& audioProcessor;
 
-    // background image
+    // background image, scaled to the editor size in resized()
     juce::Image backgroundImage;
 
     // meters
     HorizontalMeterLeft meterLeft;
     HorizontalMeterRight meterRight;
+    juce::Label loudnessLabel;
+    MeterSnapshot meterSnapshot;
 
     // IR loader GUI:
     juce::TextButton loadBtn;
     std::unique_ptr<juce::FileChooser> fileChooser;
     juce::Label irNameLabel;
-    RotarySliderWithLabels xPosSlider, yPosSlider;
+    RotarySliderWithLabels xPosSlider, yPosSlider, xDistanceSlider, yDistanceSlider;
+    juce::ToggleButton interpolationButton;
+    std::shared_ptr<const ImpulseResponse> drawnIR;
     juce::ComboBox comboTypeBox, mikTypeBox;
     juce::Atomic<bool> userIRLoaded{ false };
     
@@ -411,12 +520,17 @@ private:
         highCutSlopeSliderAttachment,
         xPosSliderAttachment,
         yPosSliderAttachment,
+        xDistanceSliderAttachment,
+        yDistanceSliderAttachment,
         outputGainSliderAttachment;
 
     using ButtonAttachment = APVTS::ButtonAttachment;
-    ButtonAttachment lowCutBypassButtonAttachment, peakBypassButtonAttachment, highCutBypassButtonAttachment, irBypassButtonAttachment;
+    ButtonAttachment lowCutBypassButtonAttachment, peakBypassButtonAttachment, highCutBypassButtonAttachment, irBypassButtonAttachment,
+        interpolationButtonAttachment;
 
     std::vector<juce::Component*> getComps();
+    void loadSelectedIR();
+    void updatePositionSliders();
 
     LookAndFeel lnf;
     LookAndFeelBlue lnfb;
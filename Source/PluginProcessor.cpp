@@ -12,8 +12,6 @@
 
     add FFT analysis of loaded IR
 
-    try to interpolate between mik positions and maybe even cab types
-
   ==============================================================================
 */
 
@@ -33,10 +31,33 @@ BasicEQAudioProcessor::BasicEQAudioProcessor()
                        )
 #endif
 {
+    for (auto* param : getParameters())
+        if (auto* rap = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.addParameterListener(rap->getParameterID(), this);
+
+    irBypassedParameter = apvts.getRawParameterValue("IR Bypassed");
+    interpolationParameter = apvts.getRawParameterValue("Position Interpolation");
+    xDistanceParameter = apvts.getRawParameterValue("X Distance");
+    yDistanceParameter = apvts.getRawParameterValue("Y Distance");
+    tailThresholdParameter = apvts.getRawParameterValue("IR Tail Threshold");
+    smoothingParameter = apvts.getRawParameterValue("EQ Smoothing");
+    oversamplingParameter = apvts.getRawParameterValue("EQ Oversampling");
+    eqModeParameter = apvts.getRawParameterValue("EQ Mode");
+
+    irCatalogue->addChangeListener(this);
+    startTimerHz(parameterPollHz);
 }
 
 BasicEQAudioProcessor::~BasicEQAudioProcessor()
 {
+    stopTimer();
+    irCatalogue->removeChangeListener(this);
+    irBank->cancelResample(*this);
+    cancelPendingUpdate();
+
+    for (auto* param : getParameters())
+        if (auto* rap = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.removeParameterListener(rap->getParameterID(), this);
 }
 
 //==============================================================================
@@ -117,26 +138,73 @@ void BasicEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
     outputGain.prepare(spec);
     outputGain.setGainDecibels(0);
 
-    rmsLevelLeft.reset(sampleRate, 0.2);
-    rmsLevelRight.reset(sampleRate, 0.1);
-    rmsLevelLeft.setCurrentAndTargetValue(-100.f);
-    rmsLevelRight.setCurrentAndTargetValue(-100.f);
+    levelMeter.prepare(sampleRate);
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    const auto eqChannels = (juce::uint32)juce::jmin(2, getTotalNumOutputChannels());
+    for (size_t i = 0; i < eqPaths.size(); ++i)
+    {
+        const auto factor = 1 << i;
+        const juce::dsp::ProcessSpec pathSpec{ sampleRate * factor, (juce::uint32)(samplesPerBlock * factor), eqChannels };
+        eqPaths[i].biquads.prepare(pathSpec);
+        eqPaths[i].svfs.prepare(pathSpec);
+        eqPaths[i].coefficientsApplied = false;
 
-    updateFilters();
+        if (i > 0)
+        {
+            // polyphase half band FIRs, linear phase with a whole number of samples latency
+            oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>(eqChannels, i,
+                juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, true);
+            oversamplers[i]->initProcessing((size_t)samplesPerBlock);
+            oversamplingLatency[i] = juce::roundToInt(oversamplers[i]->getLatencyInSamples());
+        }
+    }
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    eqDelay.prepare({ sampleRate, (juce::uint32)samplesPerBlock, eqChannels });
+    eqDelay.setMaximumDelayInSamples(juce::jmax(oversamplingLatency[1], oversamplingLatency[2]));
+    eqDelay.setDelay(0.f);
+    eqDelaySamples = 0;
+    fadeBuffer.setSize((int)eqChannels, samplesPerBlock);
+    dryBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock);
+    eqBlockSize = samplesPerBlock;
+    fadeLength = juce::jmax(1, juce::roundToInt(0.02 * sampleRate));
+    fadeRemaining = 0;
+    currentEqPath = 0;
+
+    // sample rate may have changed, every band has to be redesigned, and nothing glides from the old design
+    markAllBandsChanged();
+    publishCoefficients();
+    if (coefficientMailbox.pull(activeCoefficients))
+        applyCoefficients(activeCoefficients);
 
     spec.numChannels = getTotalNumOutputChannels();
 
-    loadShippedImpulseResponses();
+    // the catalogue was scanned once for the whole process, nothing here touches the disk
+    irBank->prepare(*irCatalogue->getTable(), sampleRate);
 
-    irLoader.reset();
     irLoader.prepare(spec);
 
+    // the IR that is loaded was resampled for the previous rate, fetch it again for this one.
+    // A user IR may not have been loaded at all yet, its resampling for the previous rate is replaced
+    const auto rateChanged = juce::roundToInt(loadedIRSampleRate) != juce::roundToInt(sampleRate);
+    if (userIR != nullptr && rateChanged)
+    {
+        loadUserIR(sampleRate);
+    }
+    else if (loadedIRSampleRate > 0 && rateChanged)
+    {
+        irBlender.invalidate();
+
+        if (isInterpolatingPosition())
+            requestBlend();
+        else if (auto ir = irBank->get(loadedSelection[0], loadedSelection[1], loadedSelection[2], loadedSelection[3], sampleRate))
+            loadImpulseResponse(ir);
+    }
+
+    // a FIR EQ is designed for the sample rate as well
+    updateConvolution(false);
+    // the convolution has a direct form head, only the EQ adds latency
+    updateLatency();
+
     /*osc.initialise([](float x) { return std::sin(x); });
     osc.prepare(spec);
     osc.setFrequency(50);*/ // oscillator for testing FFT
@@ -180,7 +248,6 @@ void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
-    auto settings = getChainSettings(apvts);
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
     // guaranteed to be empty - they may contain garbage).
@@ -190,7 +257,13 @@ void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    updateFilters();
+    // coefficients are designed on the message thread, here they are only picked up.
+    // offline renders may keep the message thread busy, there it's fine to design in place
+    if (isNonRealtime())
+        publishCoefficients();
+
+    if (coefficientMailbox.pull(activeCoefficients))
+        applyCoefficients(activeCoefficients);
 
     juce::dsp::AudioBlock<float> block(buffer);
 
@@ -198,43 +271,73 @@ void BasicEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     //juce::dsp::ProcessContextReplacing<float> stereoContext(block);
     //osc.process(stereoContext);
 
-    // input block divided to mono L/R for EQ processing
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-    
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    // a kernel with the EQ in it wants the input from before the EQ, one without wants it EQ'd, while
+    // irLoader switches from one kind to the other it wants both. Chunks of the prepared size for dryBuffer
+    irLoader.beginBlock();
+    const auto numSamples = (int)block.getNumSamples();
+    const auto chunkSize = dryBuffer.getNumSamples() > 0 ? dryBuffer.getNumSamples() : numSamples;
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
-    
-    //input stereo block sent to irLoader
-    //DBG((int)!settings.irBypassed);
-    if (!settings.irBypassed)
+    for (int start = 0; start < numSamples; start += chunkSize)
     {
-        if (irLoader.getCurrentIRSize() > 0)
+        const auto n = juce::jmin(chunkSize, numSamples - start);
+        auto chunk = block.getSubBlock((size_t)start, (size_t)n);
+
+        // also runs before the first IR is in, the switcher passes audio through until then.
+        // With the EQ in the kernel it runs with the IR bypassed too, the kernel is the EQ alone then
+        const auto needsDry = irLoader.needsDryInput();
+        const auto convolve = needsDry || irBypassedParameter->load() < 0.5f;
+
+        juce::dsp::AudioBlock<float> dry;
+        if (needsDry)
+        {
+            dry = juce::dsp::AudioBlock<float>(dryBuffer).getSubBlock(0, (size_t)n);
+            dry.copyFrom(chunk);
+        }
+
+        // both channels go through the EQ together
+        if (!convolve || irLoader.needsEqInput())
+        {
+            ScopedStageTimer timer(stageTicks[Stage_EQ]);
+            processEq(chunk);
+        }
+
+        if (convolve)
         {
-            irLoader.process(juce::dsp::ProcessContextReplacing<float>(block));
+            ScopedStageTimer timer(stageTicks[Stage_Convolution]);
+            irLoader.process(juce::dsp::ProcessContextReplacing<float>(chunk), dry);
         }
     }
 
     // APPLY GAIN KNOB
-    outputGain.process(juce::dsp::ProcessContextReplacing<float>(block));
-
-    // CALC and SET RMS LEVEL OF L&R CHANNELS
-    rmsLevelLeft.skip(buffer.getNumSamples());
-    rmsLevelRight.skip(buffer.getNumSamples());
-    const auto valueLeft = juce::Decibels::gainToDecibels(buffer.getRMSLevel(0, 0, buffer.getNumSamples()));
-    if (valueLeft < rmsLevelLeft.getCurrentValue()) { rmsLevelLeft.setTargetValue(valueLeft); } // if the new value is lower than the current one, apply smoothing
-    else { rmsLevelLeft.setCurrentAndTargetValue(valueLeft); }  // if the new value is greater than the current one, do not apply smoothing - so that transients are shown well
-
-    const auto valueRight = juce::Decibels::gainToDecibels(buffer.getRMSLevel(1, 0, buffer.getNumSamples()));
-    if (valueRight < rmsLevelRight.getCurrentValue()) { rmsLevelRight.setTargetValue(valueRight); } // if the new value is lower than the current one, apply smoothing
-    else { rmsLevelRight.setCurrentAndTargetValue(valueRight); }  // if the new value is greater than the current one, do not apply smoothing - so that transients are shown well
-    
+    {
+        ScopedStageTimer timer(stageTicks[Stage_OutputGain]);
+        outputGain.process(juce::dsp::ProcessContextReplacing<float>(block));
+    }
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    // peak, true peak, RMS and loudness of L&R
+    if (analysisConsumers[Analysis_Meters].load(std::memory_order_relaxed) > 0)
+    {
+        ScopedStageTimer timer(stageTicks[Stage_Metering]);
+        // measured from scratch whenever the meters open, integrated loudness included
+        if (!metersRunning)
+            levelMeter.reset();
+        metersRunning = true;
+
+        levelMeter.process(buffer);
+    }
+    else
+    {
+        metersRunning = false;
+    }
+
+    if (analysisConsumers[Analysis_Spectrum].load(std::memory_order_relaxed) > 0)
+    {
+        ScopedStageTimer timer(stageTicks[Stage_AnalyzerTaps]);
+        // mono only feeds the left one, the analyzer knows
+        leftChannelFifo.update(buffer);
+        if (buffer.getNumChannels() > 1)
+            rightChannelFifo.update(buffer);
+    }
 
     //DBG("IR size is " << irLoader.getCurrentIRSize());
     // This is the place where you'd normally do the guts of your plugin's
@@ -283,7 +386,8 @@ void BasicEQAudioProcessor::setStateInformation (const void* data, int sizeInByt
     if (tree.isValid())
     {
         apvts.replaceState(tree);
-        updateFilters();
+        markAllBandsChanged();
+        triggerAsyncUpdate();
     }
 }
 
@@ -316,28 +420,155 @@ Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRat
                                                                 juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
 }
 
-juce::File BasicEQAudioProcessor::updateLoadedIR(int comboTypeID, int mikTypeID, int yPos, int xPos)
+std::shared_ptr<const ImpulseResponse> BasicEQAudioProcessor::updateLoadedIR(int comboTypeID, int mikTypeID, int yPos, int xPos)
+{
+    if (isInterpolatingPosition())
+    {
+        // yPos/xPos are the stepped positions, the blend uses the distance parameters
+        loadedSelection = { comboTypeID, mikTypeID, yPos, xPos };
+        userIR.reset();
+        requestBlend();
+        return nullptr;
+    }
+
+    // comes out of the IR bank already decoded and at the session rate,
+    // no disk access unless the bank hasn't got to it yet
+    auto ir = irBank->get(comboTypeID, mikTypeID, yPos, xPos, getSampleRate());
+    if (ir != nullptr)
+    {
+        loadedSelection = { comboTypeID, mikTypeID, yPos, xPos };
+        userIR.reset();
+        loadImpulseResponse(ir);
+    }
+
+    return ir;
+}
+
+std::shared_ptr<const ImpulseResponse> BasicEQAudioProcessor::loadUserImpulseResponse(const juce::File& file)
 {
-    irLoader.reset();
-    // load IR, stereo, trimmed, normalized, size 0 = original IR size
-    irLoader.loadImpulseResponse(impulseResponseArray[comboTypeID][mikTypeID][yPos][xPos], juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::yes, 0, juce::dsp::Convolution::Normalise::yes);
-    /*DBG("Loaded IR from array " << comboTypeID << " " << mikTypeID << " " << yPos << " " << xPos);
-    DBG("File name is " << impulseResponseArray[comboTypeID][mikTypeID][yPos][xPos].getFileName());
-    DBG("IR Size is " << irLoader.getCurrentIRSize());*/
-    return impulseResponseArray[comboTypeID][mikTypeID][yPos][xPos];
+    auto original = IrBank::decode(file);
+    if (original == nullptr)
+        return nullptr;
+
+    // kept at the rate of the file, so it can be resampled again when the session rate changes
+    userIR = original;
+    loadUserIR(getSampleRate());
+    return original;
 }
 
-void BasicEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+void BasicEQAudioProcessor::loadUserIR(double sampleRate)
 {
-    // calculate peak coefficients
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    irBank->cancelResample(*this);
+
+    // resampling a long file takes a while, the bank's thread does it and handleAsyncUpdate() loads
+    // the result. The IR that was playing keeps playing meanwhile
+    if (sampleRate > 0 && juce::roundToInt(userIR->sampleRate) != juce::roundToInt(sampleRate))
+        irBank->requestResample(*this, userIR, sampleRate);
+    else
+        loadImpulseResponse(userIR);
+}
 
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+void BasicEQAudioProcessor::dispatchPendingUpdates()
+{
+    handleUpdateNowIfNeeded();
+    timerCallback();
+}
 
-    // initializing LR chains, coefficients need to be dereferenced (get values they point at)
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+void BasicEQAudioProcessor::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    // the catalogue has a new table (IRs were installed or changed on disk). Every instance
+    // prepares the shared bank with it, only the first one changes anything there
+    irBank->prepare(*irCatalogue->getTable(), getSampleRate());
+
+    // a shipped IR that is loaded is fetched again, a user IR stays
+    if (loadedIR == nullptr || userIR != nullptr)
+        return;
+
+    if (isInterpolatingPosition())
+    {
+        irBlender.invalidate();
+        requestBlend();
+    }
+    else if (auto ir = irBank->get(loadedSelection[0], loadedSelection[1], loadedSelection[2], loadedSelection[3], getSampleRate()))
+    {
+        loadImpulseResponse(ir);
+    }
+}
+
+void BasicEQAudioProcessor::loadImpulseResponse(std::shared_ptr<const ImpulseResponse> ir)
+{
+    loadedIRSampleRate = ir->sampleRate;
+    untrimmedIR = ir;
+
+    // near silent tails only cost CPU, cut where the energy left drops below the threshold
+    loadedIR = IrBank::truncateTail(ir, tailThresholdParameter->load());
+
+    // prepareToPlay() gets here on whatever thread the host prepares on, the state is only changed on the message thread
+    loadedIRLengthMs = 1000.0 * loadedIR->buffer.getNumSamples() / loadedIR->sampleRate;
+    triggerAsyncUpdate();
+
+    // the old IR keeps playing until the new one is ready, then they are crossfaded
+    updateConvolution(true);
+}
+
+static int collectStages(const CoefficientSet& set, BiquadCoefficients* stages, int* slots);
+
+void BasicEQAudioProcessor::updateConvolution(bool irChanged)
+{
+    const auto mode = (int)eqModeParameter->load();
+    const auto irBypassed = irBypassedParameter->load() > 0.5f;
+
+    if (mode == EqMode_IIR || mode == EqMode_Frozen)
+    {
+        // the live EQ is back right away: irLoader feeds the kernel without the EQ from the IIR stage and
+        // crossfades to it as usual. With nothing to convolve with that kernel is a single 1, which keeps
+        // the switch seamless, and the convolution stops once it is through
+        kernelDesigner.cancel();
+        if (loadedKernel == Kernel_WithEq && (irBypassed || loadedIR == nullptr))
+        {
+            irLoader.load(EqKernelDesigner::merge(nullptr, { 1.f }, getSampleRate()));
+            loadedKernel = Kernel_Identity;
+        }
+        else if (loadedIR != nullptr && (irChanged || (!irBypassed && loadedKernel != Kernel_IR)))
+        {
+            irLoader.load(loadedIR);
+            loadedKernel = Kernel_IR;
+        }
+
+        // without an IR the live EQ is cheaper than any kernel
+        if (mode == EqMode_IIR || irBypassed || loadedIR == nullptr || getSampleRate() <= 0)
+            return;
+
+        // frozen again once the EQ held still for a second
+        EqKernelDesigner::Request request{ getChainSettings(apvts), getSampleRate(), EqKernelDesigner::Phase_Iir, loadedIR };
+        {
+            const juce::ScopedLock sl(designLock);
+            request.iir.numStages = collectStages(designedCoefficients, request.iir.stages.data(), request.iir.slots.data());
+            request.iir.oversampling = designedCoefficients.eqOversampling;
+            request.iir.delay = designedCoefficients.eqLatency;
+        }
+        request.settleMs = 1000;
+        kernelDesigner.request(request);
+        return;
+    }
+
+    if (getSampleRate() <= 0)
+        return;
+
+    // the IIR stage keeps running until the merged kernel is handed to irLoader in handleAsyncUpdate()
+    kernelDesigner.request({ getChainSettings(apvts), getSampleRate(),
+                             mode == EqMode_LinearPhase ? EqKernelDesigner::Phase_Linear : EqKernelDesigner::Phase_Minimum,
+                             irBypassed ? nullptr : loadedIR });
+}
+
+bool BasicEQAudioProcessor::isInterpolatingPosition() const
+{
+    return interpolationParameter->load() > 0.5f;
+}
+
+void BasicEQAudioProcessor::requestBlend()
+{
+    irBlender.request({ loadedSelection[0], loadedSelection[1], xDistanceParameter->load(), yDistanceParameter->load(), getSampleRate() });
 }
 
 void updateCoefficients(Coefficients& old, const Coefficients& replacements)
@@ -345,43 +576,390 @@ void updateCoefficients(Coefficients& old, const Coefficients& replacements)
     *old = *replacements;
 }
 
-void BasicEQAudioProcessor::updateLowCutFilter(const ChainSettings& chainSettings)
+BiquadCoefficients toBiquadCoefficients(const juce::dsp::IIR::Coefficients<float>& coefficients)
+{
+    // every design used here is even order, so each section is a full biquad
+    jassert(coefficients.coefficients.size() == 5);
+    const auto& c = coefficients.coefficients;
+    return { c[0], c[1], c[2], c[3], c[4] };
+}
+
+void designLowCut(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate)
 {
     // lowCutSlope = (0,1,2,3) -> need to get order = (2,4,6,8) -> hence 2*(slope+1)
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    // init left chain
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    auto lowCutCoefficients = makeLowCutFilter(chainSettings, sampleRate);
+    for (int i = 0; i < lowCutCoefficients.size(); ++i)
+        set.lowCut[i] = toBiquadCoefficients(*lowCutCoefficients[i]);
 
-    // init right chain
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    set.lowCutSlope = chainSettings.lowCutSlope;
+    set.lowCutBypassed = chainSettings.lowCutBypassed;
+    set.targets.lowCutFreq = chainSettings.lowCutFreq;
 }
 
-void BasicEQAudioProcessor::updateHighCutFilter(const ChainSettings& chainSettings)
+void designPeak(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate)
 {
-    // compute highcut coefficients
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
-    // init both chains, update filter
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    set.peak = toBiquadCoefficients(*makePeakFilter(chainSettings, sampleRate));
+    set.peakBypassed = chainSettings.peakBypassed;
+    set.targets.peakFreq = chainSettings.peakFreq;
+    set.targets.peakGainInDecibels = chainSettings.peakGainInDecibels;
+    set.targets.peakQuality = chainSettings.peakQuality;
+}
 
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+void designHighCut(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate)
+{
+    auto highCutCoefficients = makeHighCutFilter(chainSettings, sampleRate);
+    for (int i = 0; i < highCutCoefficients.size(); ++i)
+        set.highCut[i] = toBiquadCoefficients(*highCutCoefficients[i]);
 
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    set.highCutSlope = chainSettings.highCutSlope;
+    set.highCutBypassed = chainSettings.highCutBypassed;
+    set.targets.highCutFreq = chainSettings.highCutFreq;
 }
 
-void BasicEQAudioProcessor::updateFilters()
+void BasicEQAudioProcessor::publishCoefficients()
 {
+    const juce::ScopedLock sl(designLock);
+
+    const auto sampleRate = getSampleRate();
+    if (sampleRate <= 0)
+        return; // not prepared yet, the flags stay set for prepareToPlay()
+
+    // flags are cleared before the settings are read, so a change that lands in between
+    // is not lost - it just gets designed again on the next update
+    bool lowCut = lowCutChanged.compareAndSetBool(false, true);
+    bool peak = peakChanged.compareAndSetBool(false, true);
+    bool highCut = highCutChanged.compareAndSetBool(false, true);
+
+    if (!lowCut && !peak && !highCut)
+        return;
+
     auto chainSettings = getChainSettings(apvts);
 
-    updateLowCutFilter(chainSettings);
-    updateHighCutFilter(chainSettings);
-    updatePeakFilter(chainSettings);
+    // at another rate every band needs a new design
+    const auto oversampling = chooseEqOversampling(chainSettings, designedCoefficients.eqOversampling);
+    if (oversampling != designedCoefficients.eqOversampling)
+        lowCut = peak = highCut = true;
+
+    const auto designRate = sampleRate * (1 << oversampling);
+    if (lowCut) designLowCut(designedCoefficients, chainSettings, designRate);
+    if (highCut) designHighCut(designedCoefficients, chainSettings, designRate);
+    if (peak) designPeak(designedCoefficients, chainSettings, designRate);
+
+    designedCoefficients.eqOversampling = oversampling;
+    designedCoefficients.eqLatency = getEqLatency();
+    designedEqOversampling = oversampling;
+    coefficientMailbox.push(designedCoefficients);
+}
+
+int BasicEQAudioProcessor::chooseEqOversampling(const ChainSettings& chainSettings, int current) const
+{
+    const auto mode = (int)oversamplingParameter->load();
+    if (mode == 0)
+        return 0;
+
+    // on above the threshold, off only a bit below it, so a band moved around there doesn't keep switching
+    const auto threshold = oversamplingThreshold * getSampleRate() * (current == 0 ? 1.0 : 0.8);
+    const auto isAbove = (!chainSettings.lowCutBypassed && chainSettings.lowCutFreq > threshold)
+                      || (!chainSettings.peakBypassed && chainSettings.peakFreq > threshold)
+                      || (!chainSettings.highCutBypassed && chainSettings.highCutFreq > threshold);
+
+    return isAbove ? mode : 0;
+}
+
+int BasicEQAudioProcessor::getEqLatency() const
+{
+    // latency of the chosen factor, reported whether or not a band is high enough for it to run
+    return oversamplingLatency[(size_t)oversamplingParameter->load()];
+}
+
+void BasicEQAudioProcessor::updateLatency()
+{
+    // of what is heard: the IIR stage keeps playing after "EQ Mode" changed, until the kernel with the EQ in it
+    // was handed to irLoader. Frozen kernels carry the delay of the live chain
+    const auto eqLatency = loadedKernel == Kernel_WithEq && loadedKernelPhase != EqKernelDesigner::Phase_Iir
+                         ? EqKernelDesigner::getLatency(loadedKernelPhase, getSampleRate())
+                         : getEqLatency();
+
+    const auto latency = PartitionedConvolution::latencySamples + eqLatency;
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+void BasicEQAudioProcessor::handleAsyncUpdate()
+{
+    publishCoefficients();
+
+    if (positionChanged.compareAndSetBool(false, true))
+    {
+        if (isInterpolatingPosition())
+        {
+            userIR.reset();
+            requestBlend();
+        }
+        else if (interpolationToggled.get() && userIR == nullptr)
+        {
+            // back to the measured position the X/Y Position parameters point at
+            updateLoadedIR(loadedSelection[0], loadedSelection[1],
+                           (int)apvts.getRawParameterValue("Y Position")->load(), (int)apvts.getRawParameterValue("X Position")->load());
+        }
+
+        interpolationToggled = false;
+    }
+
+    if (tailThresholdChanged.compareAndSetBool(false, true) && untrimmedIR != nullptr)
+        loadImpulseResponse(untrimmedIR);
+
+    if (kernelChanged.compareAndSetBool(false, true))
+        updateConvolution(false);
+
+    // updateConvolution() cancels or supersedes anything that doesn't match the parameters any more
+    auto phase = EqKernelDesigner::Phase_Linear;
+    if (auto kernel = kernelDesigner.takeResult(&phase))
+    {
+        irLoader.load(kernel, true);
+        loadedKernel = Kernel_WithEq;
+        loadedKernelPhase = phase;
+    }
+
+    // a user IR the bank resampled, dropped if another IR or rate came in meanwhile
+    if (auto resampled = irBank->takeResampled(*this))
+        if (userIR != nullptr && juce::roundToInt(resampled->sampleRate) == juce::roundToInt(getSampleRate()))
+            loadImpulseResponse(resampled);
+
+    // a blend that finished after the user went back to stepped positions or loaded a file is dropped
+    if (auto blended = irBlender.takeResult())
+        if (isInterpolatingPosition() && userIR == nullptr)
+            loadImpulseResponse(blended);
+
+    updateLatency();
+
+    const auto irLengthMs = loadedIRLengthMs.load();
+    if (irLengthMs > 0 && (double)apvts.state.getProperty("IR Length ms", 0.0) != irLengthMs)
+        apvts.state.setProperty("IR Length ms", irLengthMs, nullptr);
+}
+
+// coefficients per state slot: 0-3 low cut, 4 peak, 5-8 high cut
+static std::array<BiquadCoefficients, StereoBiquadCascade::MaxStages> getSlotCoefficients(const CoefficientSet& set)
+{
+    std::array<BiquadCoefficients, StereoBiquadCascade::MaxStages> slotCoefficients;
+    std::copy(set.lowCut.begin(), set.lowCut.end(), slotCoefficients.begin());
+    slotCoefficients[4] = set.peak;
+    std::copy(set.highCut.begin(), set.highCut.end(), slotCoefficients.begin() + 5);
+    return slotCoefficients;
+}
+
+// the active stages in chain order (low cut, peak, high cut), each biquad keeps its own state slot
+static int collectStages(const CoefficientSet& set, BiquadCoefficients* stages, int* slots)
+{
+    const auto slotCoefficients = getSlotCoefficients(set);
+    int numStages = 0;
+
+    auto add = [&](int slot)
+    {
+        stages[numStages] = slotCoefficients[(size_t)slot];
+        slots[numStages++] = slot;
+    };
+
+    if (!set.lowCutBypassed)
+        for (int i = 0; i <= set.lowCutSlope; ++i)
+            add(i);
+
+    if (!set.peakBypassed)
+        add(4);
+
+    if (!set.highCutBypassed)
+        for (int i = 0; i <= set.highCutSlope; ++i)
+            add(5 + i);
+
+    return numStages;
+}
+
+static bool hasSameLayout(const CoefficientSet& a, const CoefficientSet& b)
+{
+    return a.lowCutSlope == b.lowCutSlope && a.highCutSlope == b.highCutSlope && a.lowCutBypassed == b.lowCutBypassed
+        && a.peakBypassed == b.peakBypassed && a.highCutBypassed == b.highCutBypassed;
+}
+
+void BasicEQAudioProcessor::applyCoefficients(const CoefficientSet& set)
+{
+    // audio thread. A set designed for another rate starts the path for that rate from scratch
+    // and crossfades over to it
+    if (set.eqOversampling != currentEqPath)
+    {
+        auto& path = eqPaths[(size_t)set.eqOversampling];
+        path.biquads.reset();
+        path.svfs.reset();
+        path.coefficientsApplied = false;
+
+        if (set.eqOversampling > 0)
+            oversamplers[(size_t)set.eqOversampling]->reset();
+        else
+            eqDelay.reset();
+
+        fadingEqPath = currentEqPath;
+        fadeRemaining = eqPaths[(size_t)currentEqPath].coefficientsApplied ? fadeLength : 0;
+        currentEqPath = set.eqOversampling;
+    }
+
+    if (set.eqLatency != eqDelaySamples)
+    {
+        eqDelaySamples = set.eqLatency;
+        eqDelay.setDelay((float)eqDelaySamples);
+    }
+
+    applyCoefficients(eqPaths[(size_t)currentEqPath], set);
+}
+
+void BasicEQAudioProcessor::applyCoefficients(EqPath& path, const CoefficientSet& set)
+{
+    // With EQ Smoothing on, frequency, gain and Q of the active bands glide to the new setting
+    // on the SVF cascade and the biquads take over again once it got there.
+    // Slope and bypass changes switch right away
+    const auto wasGliding = path.svfs.isGliding();
+    path.latest = set;
+
+    if (path.coefficientsApplied && smoothingParameter->load() > 0.5f && hasSameLayout(set, path.applied))
+    {
+        path.svfs.setTargets(set.targets, true);
+        if (path.svfs.isGliding())
+        {
+            // starts from the state of the biquads, tuned to where they are
+            if (!wasGliding)
+                path.svfs.takeStateFrom(path.biquads, getSlotCoefficients(path.applied).data());
+            return;
+        }
+    }
+
+    // a glide that is cut short hands over from wherever it got to
+    switchToBiquads(path, set, wasGliding);
+}
+
+void BasicEQAudioProcessor::switchToBiquads(EqPath& path, const CoefficientSet& set, bool fromSvf)
+{
+    std::array<BiquadCoefficients, StereoBiquadCascade::MaxStages> stages;
+    std::array<int, StereoBiquadCascade::MaxStages> slots;
+    const auto numStages = collectStages(set, stages.data(), slots.data());
+
+    path.biquads.setStages(stages.data(), slots.data(), numStages);
+    if (fromSvf)
+        path.svfs.handStateTo(path.biquads, getSlotCoefficients(set).data());
+
+    // the SVFs stay tuned to the same setting, that is where the next glide starts
+    path.svfs.setLayout(slots.data(), numStages, set.lowCutSlope, set.highCutSlope);
+    path.svfs.setTargets(set.targets, false);
+
+    path.applied = set;
+    path.coefficientsApplied = true;
+}
+
+void BasicEQAudioProcessor::processEq(const juce::dsp::AudioBlock<float>& fullBlock)
+{
+    if (eqBlockSize == 0)
+        return; // not prepared yet
+
+    auto block = fullBlock.getSubsetChannelBlock(0, (size_t)fadeBuffer.getNumChannels());
+    const auto numSamples = (int)block.getNumSamples();
+    juce::dsp::AudioBlock<float> fadeBlock(fadeBuffer);
+
+    // the oversamplers take no more than the prepared block size at once
+    for (int start = 0; start < numSamples; start += eqBlockSize)
+    {
+        const auto n = juce::jmin(eqBlockSize, numSamples - start);
+        auto chunk = block.getSubBlock((size_t)start, (size_t)n);
+
+        if (fadeRemaining == 0)
+        {
+            processEqPath(currentEqPath, chunk);
+            continue;
+        }
+
+        // the path that is left gets a copy of the input and fades out under the new one
+        auto fadeChunk = fadeBlock.getSubBlock(0, (size_t)n);
+        fadeChunk.copyFrom(chunk);
+        processEqPath(fadingEqPath, fadeChunk);
+        processEqPath(currentEqPath, chunk);
+
+        const auto numFading = juce::jmin(n, fadeRemaining);
+        for (size_t ch = 0; ch < chunk.getNumChannels(); ++ch)
+        {
+            auto* data = chunk.getChannelPointer(ch);
+            const auto* old = fadeChunk.getChannelPointer(ch);
+
+            for (int i = 0; i < numFading; ++i)
+            {
+                const auto gain = 1.f - (float)(fadeRemaining - i) / (float)fadeLength;
+                data[i] = old[i] + gain * (data[i] - old[i]);
+            }
+        }
+
+        fadeRemaining -= numFading;
+    }
+}
+
+void BasicEQAudioProcessor::processEqPath(int index, juce::dsp::AudioBlock<float>& block)
+{
+    auto& path = eqPaths[(size_t)index];
+
+    auto run = [this, &path](const juce::dsp::AudioBlock<float>& pathBlock)
+    {
+        if (path.svfs.isGliding())
+        {
+            path.svfs.process(pathBlock);
+            if (!path.svfs.isGliding())
+                switchToBiquads(path, path.latest, true);
+        }
+        else
+        {
+            path.biquads.process(pathBlock);
+        }
+    };
+
+    if (index == 0)
+    {
+        run(block);
+        if (eqDelaySamples > 0)
+            eqDelay.process(juce::dsp::ProcessContextReplacing<float>(block));
+    }
+    else
+    {
+        auto& oversampler = *oversamplers[(size_t)index];
+        run(oversampler.processSamplesUp(block));
+        oversampler.processSamplesDown(block);
+    }
+}
+
+void BasicEQAudioProcessor::markAllBandsChanged()
+{
+    lowCutChanged.set(true);
+    peakChanged.set(true);
+    highCutChanged.set(true);
+}
+
+void BasicEQAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    // can be called from any thread (host automation comes in on the audio thread), so this only
+    // sets flags. triggerAsyncUpdate() posts to the OS message queue and may block, timerCallback() picks them up
+    juce::ignoreUnused(newValue);
+
+    if (parameterID.startsWith("LowCut")) { lowCutChanged.set(true); kernelChanged.set(true); }
+    else if (parameterID.startsWith("Peak")) { peakChanged.set(true); kernelChanged.set(true); }
+    else if (parameterID.startsWith("HighCut")) { highCutChanged.set(true); kernelChanged.set(true); }
+    else if (parameterID == "EQ Mode" || parameterID == "IR Bypassed") { kernelChanged.set(true); }
+    else if (parameterID == "Position Interpolation") { interpolationToggled.set(true); positionChanged.set(true); }
+    else if (parameterID == "X Distance" || parameterID == "Y Distance") { positionChanged.set(true); }
+    else if (parameterID == "IR Tail Threshold") { tailThresholdChanged.set(true); }
+    else if (parameterID == "EQ Oversampling") { markAllBandsChanged(); kernelChanged.set(true); }
+    else { return; }
+
+    parametersChanged.set(true);
+}
+
+void BasicEQAudioProcessor::timerCallback()
+{
+    // the redesign itself happens in publishCoefficients(), the same work as for the updates the
+    // message thread and the worker threads trigger
+    if (parametersChanged.compareAndSetBool(false, true))
+        handleAsyncUpdate();
 }
 
     // Here are parameters defined
@@ -410,6 +988,11 @@ juce::AudioProcessorValueTreeState::ParameterLayout
     
     layout.add(std::make_unique<juce::AudioParameterChoice>("Y Position", "Y Position", yPosChoices, 0));
 
+    // continuous mic position, blended from the neighbouring measured IRs (skewed so 10 cm sits in the middle)
+    layout.add(std::make_unique<juce::AudioParameterBool>("Position Interpolation", "Position Interpolation", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("X Distance", "X Distance", juce::NormalisableRange<float>(0.f, 8.f, 0.01f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Y Distance", "Y Distance", juce::NormalisableRange<float>(0.f, 40.f, 0.01f, 0.5f), 0.f));
+
     juce::StringArray stringArray; // String array containing 4 choices for slope setting
     for (int i = 0; i < 4; i++) {
         juce::String str;
@@ -429,63 +1012,20 @@ juce::AudioProcessorValueTreeState::ParameterLayout
     layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed", "Peak Bypassed", false));
     layout.add(std::make_unique<juce::AudioParameterBool>("IR Bypassed", "IR Bypassed", false));
 
-    return layout;
-}
+    // automation of frequency, gain and Q glides at a fixed control rate instead of jumping once per block
+    layout.add(std::make_unique<juce::AudioParameterBool>("EQ Smoothing", "EQ Smoothing", true));
 
-void BasicEQAudioProcessor::loadShippedImpulseResponses()
-{
-    // impulseResponseArray[typ komba][typ mikrofonu][pozice Y][pozice X]
-    // toto nasleduje strukturu slozek v Data
-    // 
-    
-    int comboType, mikType, yPosition, xPosition;
-    impulseResponseArray.resize(3);
-    for (auto& array_2 : impulseResponseArray) {
-        array_2.resize(3);
-        for (auto& array_1 : array_2) {
-            array_1.resize(3);
-            for (auto& array_0 : array_1) {
-                array_0.resize(12);
-            }
-        }
-    }
-    /*DBG(impulseResponseArray.size());
-    DBG(impulseResponseArray[0].size());
-    DBG(impulseResponseArray[0][0].size());
-    DBG(impulseResponseArray[0][0][0].size());*/
-
-    //DBG(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getParentDirectory().getParentDirectory().getParentDirectory().getParentDirectory().getParentDirectory().getChildFile("Data").getFullPathName());
-    //juce::File dataFolder = juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getParentDirectory().getParentDirectory().getParentDirectory().getParentDirectory().getParentDirectory().getChildFile("Data");
-    juce::File dataFolder = juce::File::getSpecialLocation(juce::File::SpecialLocationType::commonApplicationDataDirectory).getChildFile("PechacekIRLoader").getChildFile("Data");
-    //DBG(dataFolder.getFullPathName());
-    for (juce::DirectoryEntry entry : juce::RangedDirectoryIterator(/*juce::File("C:/Users/knize/Documents/VST_CODE/BasicEQ/Data")*/dataFolder, true, "*.wav", 2)) {
-        juce::String filename = entry.getFile().getFileNameWithoutExtension();
-        juce::StringArray filenameArray;
-        filenameArray.addTokens(filename, "_", "\"");
-        
-        if (filenameArray[0] == "57A") { mikType = 0; }
-        else if (filenameArray[0] == "kalib") { mikType = 1; }
-        else { mikType = 2; }
-        if (filenameArray[1] == "0cm") { yPosition = 0; }
-        else if (filenameArray[1] == "10cm") { yPosition = 1; }
-        else { yPosition = 2; }
-        if (filenameArray[2] == "Mar") { comboType = 0; }
-        else if (filenameArray[2] == "MM") { comboType = 1; }
-        else { comboType = 2; }
-        xPosition = filenameArray[3].getIntValue();
-
-        juce::File file = entry.getFile();
-        
-        impulseResponseArray.getReference(comboType).getReference(mikType).getReference(yPosition).set(xPosition, file);
-        //DBG("added " << file.getFileName());
-
-        //juce::String filepath = impulseResponseArray.getUnchecked(comboType).getUnchecked(mikType).getUnchecked(yPosition).getUnchecked(xPosition).getFullPathName();
-        /*juce::String filepath = impulseResponseArray[comboType][mikType][yPosition][xPosition].getFullPathName();
-        DBG("Loading " << filename << " into array " << comboType << " " << mikType << " " << yPosition << " " << xPosition);
-        DBG("Loaded " << impulseResponseArray[comboType][mikType][yPosition][xPosition].getFullPathName() << " into array");
-        DBG("File in 2 2 2 10: " << impulseResponseArray.getUnchecked(2).getUnchecked(2).getUnchecked(2).getUnchecked(10).getFullPathName());*/
-        filenameArray.clear();
-    }
+    // factor for the EQ while a band is up where the bilinear designs cramp, latency is reported whenever it is on
+    layout.add(std::make_unique<juce::AudioParameterChoice>("EQ Oversampling", "EQ Oversampling", juce::StringArray("Off", "2x", "4x"), 0));
+
+    // EqMode, the FIR modes and a frozen EQ run inside the IR convolution
+    layout.add(std::make_unique<juce::AudioParameterChoice>("EQ Mode", "EQ Mode", juce::StringArray("IIR", "Linear Phase", "Minimum Phase", "Frozen"), 0));
+
+    // residual energy where IR tails are cut
+    layout.add(std::make_unique<juce::AudioParameterFloat>("IR Tail Threshold", "IR Tail Threshold",
+        juce::NormalisableRange<float>(-120.f, -40.f, 1.f), -90.f));
+
+    return layout;
 }
 
 //==============================================================================
@@ -495,10 +1035,26 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new BasicEQAudioProcessor();
 }
 
-float BasicEQAudioProcessor::getRMSValue(const int channel) const
+void BasicEQAudioProcessor::addAnalysisConsumer(AnalysisConsumer type)
+{
+    // whatever is still in the rings is from before the last consumer went away, the analyzer starts on fresh samples.
+    // Skipped before the taps start again so nothing new is thrown away
+    if (type == Analysis_Spectrum && analysisConsumers[(size_t)type].load() == 0)
+    {
+        leftChannelFifo.skip(leftChannelFifo.getNumSamplesAvailable());
+        rightChannelFifo.skip(rightChannelFifo.getNumSamplesAvailable());
+    }
+
+    ++analysisConsumers[(size_t)type];
+}
+
+void BasicEQAudioProcessor::removeAnalysisConsumer(AnalysisConsumer type)
+{
+    jassert(analysisConsumers[(size_t)type].load() > 0);
+    --analysisConsumers[(size_t)type];
+}
+
+bool BasicEQAudioProcessor::pullMeterSnapshot(MeterSnapshot& snapshot)
 {
-    jassert(channel == 0 || channel == 1);
-    if (channel == 0) { return rmsLevelLeft.getCurrentValue(); }
-    else if (channel == 1) { return rmsLevelRight.getCurrentValue(); }
-    return 0.f;
+    return levelMeter.pullSnapshot(snapshot);
 }
\ No newline at end of file
@@ -10,6 +10,21 @@
 
 #include <JuceHeader.h>
 #include <juce_core/juce_core.h>
+#include "ChainSettings.h"
+#include "StereoBiquadCascade.h"
+#include "StereoSvfCascade.h"
+#include "IrBank.h"
+#include "IrCatalogue.h"
+#include "IrSwitcher.h"
+#include "IrBlender.h"
+#include "TripleBuffer.h"
+#include "LevelMeter.h"
+#include "EqKernelDesigner.h"
+
+// set to 1 (e.g. in the benchmark project) to measure how long every stage of processBlock() takes
+#ifndef BASICEQ_PROFILE_STAGES
+ #define BASICEQ_PROFILE_STAGES 0
+#endif
 
 template<typename T>
 struct Fifo
@@ -80,93 +95,101 @@ enum Channel
     Left    // 1
 };
 
-template<typename BlockType>
-struct SingleChannelSampleFifo
+/**
+ single producer / single consumer ring of samples. The writer copies whole blocks in with at most
+ two memcpys and never waits, the reader takes any number of samples whenever it wants.
+ If the reader falls behind and a block doesn't fit any more, that block is dropped and counted.
+ */
+struct SampleRing
 {
-    SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
-    {
-        prepared.set(false);
-    }
+    explicit SampleRing(int capacityToUse) : capacity(juce::nextPowerOfTwo(capacityToUse)), samples((size_t)capacity, 0.f) {}
 
-    void update(const BlockType& buffer)
+    // producer
+    void write(const float* data, int numSamples)
     {
-        jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        // a block bigger than the whole ring only leaves its newest samples
+        if (numSamples > capacity)
+        {
+            data += numSamples - capacity;
+            numSamples = capacity;
+        }
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        const auto w = written.load(std::memory_order_relaxed);
+        const auto r = consumed.load(std::memory_order_acquire);
+        if ((int)(w - r) + numSamples > capacity)
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+
+        const auto start = (int)(w & (juce::uint32)(capacity - 1));
+        const auto first = juce::jmin(numSamples, capacity - start);
+        std::memcpy(samples.data() + start, data, sizeof(float) * (size_t)first);
+        std::memcpy(samples.data(), data + first, sizeof(float) * (size_t)(numSamples - first));
+
+        written.store(w + (juce::uint32)numSamples, std::memory_order_release);
     }
 
-    void prepare(int bufferSize)
+    // consumer
+    int getNumReady() const
     {
-        prepared.set(false);
-        size.set(bufferSize);
-
-        bufferToFill.setSize(1,             //channel
-            bufferSize,    //num samples
-            false,         //keepExistingContent
-            true,          //clear extra space
-            true);         //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
-        prepared.set(true);
+        return (int)(written.load(std::memory_order_acquire) - consumed.load(std::memory_order_relaxed));
     }
-    //==============================================================================
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
-    bool isPrepared() const { return prepared.get(); }
-    int getSize() const { return size.get(); }
-    //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
-private:
-    Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
-    juce::Atomic<bool> prepared = false;
-    juce::Atomic<int> size = 0;
 
-    void pushNextSampleIntoFifo(float sample)
+    int read(float* dest, int numSamples)
     {
-        if (fifoIndex == bufferToFill.getNumSamples())
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
+        const auto r = consumed.load(std::memory_order_relaxed);
+        const auto n = juce::jmin(numSamples, (int)(written.load(std::memory_order_acquire) - r));
 
-            juce::ignoreUnused(ok);
+        const auto start = (int)(r & (juce::uint32)(capacity - 1));
+        const auto first = juce::jmin(n, capacity - start);
+        std::memcpy(dest, samples.data() + start, sizeof(float) * (size_t)first);
+        std::memcpy(dest + first, samples.data(), sizeof(float) * (size_t)(n - first));
 
-            fifoIndex = 0;
-        }
+        consumed.store(r + (juce::uint32)n, std::memory_order_release);
+        return n;
+    }
 
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
+    void skip(int numSamples)
+    {
+        const auto r = consumed.load(std::memory_order_relaxed);
+        consumed.store(r + (juce::uint32)juce::jlimit(0, getNumReady(), numSamples), std::memory_order_release);
     }
-};
 
-enum Slope
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
+    // blocks the writer had to drop because the reader was too slow
+    int getNumOverruns() const { return overruns.load(std::memory_order_relaxed); }
+private:
+    const int capacity;
+    std::vector<float> samples;
+    // free running counters, only their difference matters so wrapping around is fine
+    std::atomic<juce::uint32> written{ 0 }, consumed{ 0 };
+    std::atomic<int> overruns{ 0 };
 };
 
-enum Distance
+// one channel of the processed audio for the analyzer
+template<typename BlockType>
+struct SingleChannelSampleFifo
 {
-    Distance_0,
-    Distance_10,
-    Distance_40
-};
+    // about 0.7 s at 48 kHz, the analyzer reads 30 times a second
+    static constexpr int ringSize = 1 << 15;
 
-struct ChainSettings
-{
-    float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
-    float lowCutFreq{ 0 }, highCutFreq{ 0 };
-    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
-    int xPos{ 0 }, yPos{ Distance::Distance_0 };
-    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false }, irBypassed{ false };
-    float outputGainInDecibels{ 0 };
+    SingleChannelSampleFifo(Channel ch) : channelToUse(ch) {}
+
+    // audio thread, no per sample work. A mono buffer feeds its only channel
+    void update(const BlockType& buffer)
+    {
+        jassert(buffer.getNumChannels() > 0);
+        ring.write(buffer.getReadPointer(juce::jmin((int)channelToUse, buffer.getNumChannels() - 1)), buffer.getNumSamples());
+    }
+
+    //==============================================================================
+    int getNumSamplesAvailable() const { return ring.getNumReady(); }
+    int pull(float* dest, int numSamples) { return ring.read(dest, numSamples); }
+    void skip(int numSamples) { ring.skip(numSamples); }
+    int getNumOverruns() const { return ring.getNumOverruns(); }
+private:
+    Channel channelToUse;
+    SampleRing ring{ ringSize };
 };
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
@@ -185,6 +208,38 @@ enum ChainPositions
 };
 
 using Coefficients = Filter::CoefficientsPtr;
+
+enum EqMode
+{
+    EqMode_IIR,
+    EqMode_LinearPhase,   // FIR EQ, part of the convolution kernel
+    EqMode_MinimumPhase,
+    EqMode_Frozen         // IIR EQ, rendered into the kernel while it holds still
+};
+
+// plain copy of all 9 biquad slots of the chain, this is what gets handed to the audio thread
+struct CoefficientSet
+{
+    std::array<BiquadCoefficients, 4> lowCut, highCut;
+    BiquadCoefficients peak;
+    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
+    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
+    EqTargets targets;   // what the coefficients were designed from, for the smoothed EQ
+    int eqOversampling{ 0 };   // designed for the session rate times 2^eqOversampling
+    int eqLatency{ 0 };        // samples the EQ is delayed by, the same whether it is oversampled or not
+};
+
+// the EQ at one processing rate: the biquads, and the SVFs they hand over to while a band glides
+struct EqPath
+{
+    StereoBiquadCascade biquads;
+    StereoSvfCascade svfs;
+    CoefficientSet applied, latest;   // what the biquads run / what was handed in last
+    bool coefficientsApplied = false;
+};
+
+BiquadCoefficients toBiquadCoefficients(const juce::dsp::IIR::Coefficients<float>& coefficients);
+
 void updateCoefficients(Coefficients& old, const Coefficients& replacements);
 
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
@@ -235,10 +290,51 @@ inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleR
     return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
 }
 
+// these run the filter design and allocate, never call them from the audio thread
+void designLowCut(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate);
+void designPeak(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate);
+void designHighCut(CoefficientSet& set, const ChainSettings& chainSettings, double sampleRate);
+
+enum ProcessingStage
+{
+    Stage_EQ,
+    Stage_Convolution,
+    Stage_OutputGain,
+    Stage_Metering,
+    Stage_AnalyzerTaps,
+    NumProcessingStages
+};
+
+// what the audio thread feeds for the UI, each kind is only fed while something has registered for it
+enum AnalysisConsumer
+{
+    Analysis_Spectrum,  // leftChannelFifo / rightChannelFifo
+    Analysis_Meters,    // pullMeterSnapshot()
+    NumAnalysisConsumers
+};
+
+// adds the time spent in its scope to 'ticks', compiles to nothing unless BASICEQ_PROFILE_STAGES is set
+struct ScopedStageTimer
+{
+   #if BASICEQ_PROFILE_STAGES
+    explicit ScopedStageTimer(juce::int64& t) : ticks(t), start(juce::Time::getHighResolutionTicks()) {}
+    ~ScopedStageTimer() { ticks += juce::Time::getHighResolutionTicks() - start; }
+   private:
+    juce::int64& ticks;
+    juce::int64 start;
+   #else
+    explicit ScopedStageTimer(juce::int64&) {}
+   #endif
+};
+
 //==============================================================================
 /**
 */
-class BasicEQAudioProcessor  : public juce::AudioProcessor
+class BasicEQAudioProcessor  : public juce::AudioProcessor,
+                               public juce::AudioProcessorValueTreeState::Listener,
+                               private juce::AsyncUpdater,
+                               private juce::ChangeListener,
+                               private juce::Timer
 {
 public:
     //==============================================================================
@@ -278,13 +374,32 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    juce::File updateLoadedIR(int comboTypeID, int mikTypeID, int yPos, int xPos);
-    void loadShippedImpulseResponses();
-    float getRMSValue(const int channel) const;
+    //==============================================================================
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    // both return the IR that is now loaded (for drawing it), nullptr if it couldn't be read.
+    // A user IR comes back at the rate of its file, resampled it follows asynchronously
+    std::shared_ptr<const ImpulseResponse> updateLoadedIR(int comboTypeID, int mikTypeID, int yPos, int xPos);
+    std::shared_ptr<const ImpulseResponse> loadUserImpulseResponse(const juce::File& file);
+    // the IR the convolution is switching to or playing (blended ones too, tail already cut). Message thread only
+    std::shared_ptr<const ImpulseResponse> getLoadedIR() const { return loadedIR; }
+    // runs what the message loop would (async updates, the parameter timer), for the headless benchmark which has none
+    void dispatchPendingUpdates();
+    // message thread, the EQ is designed for getSampleRate() times this
+    int getEqOversamplingFactor() const { return 1 << designedEqOversampling.load(); }
+    // message thread, false if the meters measured nothing new since the last call
+    bool pullMeterSnapshot(MeterSnapshot& snapshot);
+
+    // message thread. Register while the spectrum / meters are shown, with no consumer of a kind
+    // processBlock() skips that work entirely, so instances without an editor don't pay for it
+    void addAnalysisConsumer(AnalysisConsumer type);
+    void removeAnalysisConsumer(AnalysisConsumer type);
 
     juce::File root, savedFile;
-    juce::dsp::Convolution irLoader;
-    juce::Array<juce::Array<juce::Array<juce::Array<juce::File>>>> impulseResponseArray;
+    IrSwitcher irLoader;
+    juce::SharedResourcePointer<IrCatalogue> irCatalogue;
+    juce::SharedResourcePointer<IrBank> irBank;   // one per process, every instance decodes into it
+    IrBlender irBlender{ *irBank, *this };
     static juce::AudioProcessorValueTreeState::ParameterLayout
         createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
@@ -294,18 +409,97 @@ public:
     SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
 
     juce::dsp::Gain<float> outputGain;
+
+    // accumulated high resolution ticks per ProcessingStage, only filled when BASICEQ_PROFILE_STAGES is set.
+    // read and reset these only while no audio is being processed
+    const std::array<juce::int64, NumProcessingStages>& getStageTicks() const { return stageTicks; }
+    void resetStageTicks() { stageTicks.fill(0); }
 private:
-    MonoChain leftChain, rightChain;
-    //ChainSettings chainSettings;
+    std::array<juce::int64, NumProcessingStages> stageTicks{};
+
+    void loadImpulseResponse(std::shared_ptr<const ImpulseResponse> ir);
+
+    // what is in irLoader, so prepareToPlay() can load it again at a new sample rate
+    std::array<int, 4> loadedSelection{ 0, 0, 0, 0 };   // combo, mic, y, x
+    std::shared_ptr<const ImpulseResponse> userIR;      // file from the load button, at its own rate
+    double loadedIRSampleRate = 0;
+    std::shared_ptr<const ImpulseResponse> loadedIR, untrimmedIR;
+    std::atomic<double> loadedIRLengthMs{ 0.0 };   // of loadedIR, put into the state as "IR Length ms" by handleAsyncUpdate()
+
+    bool isInterpolatingPosition() const;
+    // loads userIR at sampleRate, right away if it is at that rate already, otherwise once the bank resampled it
+    void loadUserIR(double sampleRate);
+    void requestBlend();
+    juce::Atomic<bool> positionChanged{ false }, interpolationToggled{ false }, tailThresholdChanged{ false };
+    std::atomic<float>* interpolationParameter = nullptr;
+    std::atomic<float>* xDistanceParameter = nullptr;
+    std::atomic<float>* yDistanceParameter = nullptr;
+    std::atomic<float>* tailThresholdParameter = nullptr;
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilter(const ChainSettings& chainSettings);
-    void updateHighCutFilter(const ChainSettings& chainSettings);
+    //ChainSettings chainSettings;
 
-    void updateFilters();
+    void handleAsyncUpdate() override;
+    // polls parametersChanged, parameterChanged() may be on the audio thread and can't post a message
+    void timerCallback() override;
+    static constexpr int parameterPollHz = 50;
+    juce::Atomic<bool> parametersChanged{ false };
+    // the IR catalogue has a new table
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
+
+    void publishCoefficients();
+    void applyCoefficients(const CoefficientSet& set);
+    void applyCoefficients(EqPath& path, const CoefficientSet& set);
+    void switchToBiquads(EqPath& path, const CoefficientSet& set, bool fromSvf);
+    void processEq(const juce::dsp::AudioBlock<float>& block);
+    void processEqPath(int index, juce::dsp::AudioBlock<float>& block);
+    int chooseEqOversampling(const ChainSettings& chainSettings, int current) const;
+    int getEqLatency() const;
+    void updateLatency();
+    void markAllBandsChanged();
+
+    // set by parameterChanged() when any parameter of the band moves,
+    // publishCoefficients() only redesigns the bands that are flagged
+    juce::Atomic<bool> lowCutChanged{ true }, peakChanged{ true }, highCutChanged{ true };
+
+    // designed on the message thread, picked up by processBlock() without locking or allocating
+    juce::CriticalSection designLock;
+    CoefficientSet designedCoefficients, activeCoefficients;
+    TripleBuffer<CoefficientSet> coefficientMailbox;
+
+    std::atomic<float>* smoothingParameter = nullptr;
+
+    // EQ at the session rate, 2x and 4x. With EQ Oversampling on, the oversampled path only runs while an
+    // active band is above oversamplingThreshold (of the session rate). Otherwise the session rate path is
+    // delayed by the same latency, so switching over is a short crossfade and the reported latency never changes
+    static constexpr double oversamplingThreshold = 0.2;
+    std::array<EqPath, 3> eqPaths;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 3> oversamplers;   // none for [0]
+    std::array<int, 3> oversamplingLatency{};
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> eqDelay;
+    juce::AudioBuffer<float> fadeBuffer;   // input copy for the path that is faded out
+    int eqBlockSize = 0, eqDelaySamples = 0;
+    int currentEqPath = 0, fadingEqPath = 0, fadeLength = 0, fadeRemaining = 0;
+    std::atomic<int> designedEqOversampling{ 0 };
+    std::atomic<float>* oversamplingParameter = nullptr;
+
+    // with a FIR EQ mode, or a frozen IIR EQ, the EQ is convolved into the kernel of irLoader, which then
+    // takes its input from dryBuffer and the IIR stage is skipped.
+    // Message thread, loads loadedIR as it is or asks kernelDesigner for it with the EQ merged in
+    void updateConvolution(bool irChanged);
+    EqKernelDesigner kernelDesigner{ *this };
+    enum Kernel { Kernel_IR, Kernel_Identity, Kernel_WithEq };
+    Kernel loadedKernel = Kernel_IR;   // message thread, what irLoader got last
+    EqKernelDesigner::Phase loadedKernelPhase = EqKernelDesigner::Phase_Linear;   // of the last Kernel_WithEq
+    juce::Atomic<bool> kernelChanged{ false };
+    juce::AudioBuffer<float> dryBuffer;   // input from before the EQ
+    std::atomic<float>* eqModeParameter = nullptr;
+    std::atomic<float>* irBypassedParameter = nullptr;
 
     juce::dsp::Oscillator<float> osc;
-    juce::LinearSmoothedValue<float> rmsLevelLeft, rmsLevelRight;
+    LevelMeter levelMeter;
+
+    std::array<std::atomic<int>, NumAnalysisConsumers> analysisConsumers{};
+    bool metersRunning = false;   // audio thread, false until the first metered block after the meters registered
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BasicEQAudioProcessor)
 };
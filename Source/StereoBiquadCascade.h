@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    StereoBiquadCascade.h
+    Created: 16 Oct 2026 9:41:17am
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// one second order section, normalised so that a0 == 1 (same layout as juce::dsp::IIR::Coefficients)
+struct BiquadCoefficients
+{
+    float b0{ 1.f }, b1{ 0.f }, b2{ 0.f }, a1{ 0.f }, a2{ 0.f };
+};
+
+/**
+ runs the whole EQ (up to 9 biquads) on both channels at once.
+ L and R sit next to each other in one SIMD register, so every stage is computed for both channels
+ with the same instructions. Only the active stages are handed in, the processing loop is
+ instantiated per stage count and never checks for bypassed stages.
+ Filter state is kept per slot, so a band that gets bypassed and re-enabled continues where it stopped,
+ same as a bypassed filter in a juce::dsp::ProcessorChain.
+ The output is the same as that of two chains of juce::dsp::IIR::Filter, BasicEQBenchmark --verify checks
+ it and times both. With all 9 stages it took about 28 ns per stereo frame against 65 ns for the chains
+ (x86, SSE). Interleaving into frames and back is about 1.5 ns of that, so it isn't worth keeping the
+ block interleaved between calls.
+ */
+struct StereoBiquadCascade
+{
+    static constexpr int MaxStages = 9;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    /** stages in processing order, slotIds[i] says which of the MaxStages state slots stage i uses.
+        Does not allocate, safe to call from the audio thread. */
+    void setStages(const BiquadCoefficients* newStages, const int* slotIds, int numActiveStages);
+
+    /** processes channel 0 and, if present, channel 1 of the block in place */
+    void process(const juce::dsp::AudioBlock<float>& block);
+
+    int getNumActiveStages() const { return numStages; }
+
+    /** the two transposed direct form II registers of one state slot and channel,
+        for handing the state over to another realisation of the same filter */
+    void getSlotState(int slot, int channel, float& s1, float& s2) const;
+    void setSlotState(int slot, int channel, float s1, float s2);
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    struct Stage
+    {
+        Vec b0, b1, b2, a1, a2;
+    };
+
+    struct State
+    {
+        Vec s1, s2;
+    };
+
+    template<int NumStages>
+    void processStages(Vec* frames, int numFrames) noexcept;
+
+    std::array<Stage, MaxStages> stages;
+    std::array<int, MaxStages> stageSlots{};
+    std::array<State, MaxStages> state;
+    int numStages = 0;
+
+    // interleaved frames, lane 0 = left, lane 1 = right, the remaining lanes stay 0
+    std::vector<Vec> frames;
+};
@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+
+    StereoSvfCascade.cpp
+    Created: 16 Oct 2026 7:24:38pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#include "StereoSvfCascade.h"
+
+namespace
+{
+    // Q of section 'index' of an even order Butterworth filter, the same sections juce::dsp::FilterDesign makes
+    float butterworthQ(int order, int index)
+    {
+        return (float)(1.0 / (2.0 * std::cos((2.0 * index + 1.0) * juce::MathConstants<double>::pi / (order * 2.0))));
+    }
+
+    // the first two outputs of a second order section for no input depend on its state only and, once they
+    // match, so does everything after. Rows map the SVF state (ic1, ic2) to them
+    struct ZeroInputResponse
+    {
+        double r00, r01, r10, r11;
+    };
+
+    template<typename StageType>
+    ZeroInputResponse getZeroInputResponse(const StageType& s)
+    {
+        const auto c1 = (double)s.m1 * s.a1 + (double)s.m2 * s.a2;
+        const auto c2 = -(double)s.m1 * s.a2 + (double)s.m2 * (1.0 - s.a3);
+        return { c1, c2, c1 * (2.0 * s.a1 - 1.0) + c2 * 2.0 * s.a2, -c1 * 2.0 * s.a2 + c2 * (1.0 - 2.0 * s.a3) };
+    }
+}
+
+void StereoSvfCascade::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels <= 2);
+
+    sampleRate = spec.sampleRate;
+
+    // 50 ms from one setting to the next
+    for (auto* smoother : { &lowCutFreq, &peakFreq, &highCutFreq })
+        smoother->reset(sampleRate, 0.05);
+    for (auto* smoother : { &peakGain, &peakQuality })
+        smoother->reset(sampleRate, 0.05);
+
+    frames.fill(Vec::expand(0.f));
+    reset();
+}
+
+void StereoSvfCascade::reset()
+{
+    for (auto& s : state)
+    {
+        s.ic1 = Vec::expand(0.f);
+        s.ic2 = Vec::expand(0.f);
+    }
+
+    samplesToNextUpdate = 0;
+}
+
+void StereoSvfCascade::setLayout(const int* slotIds, int numActiveStages, int lowCutSlope, int highCutSlope)
+{
+    jassert(juce::isPositiveAndNotGreaterThan(numActiveStages, MaxStages));
+
+    usesLowCut = usesPeak = usesHighCut = false;
+
+    for (int i = 0; i < numActiveStages; ++i)
+    {
+        auto& stage = stages[(size_t)i];
+        stage.slot = slotIds[i];
+
+        if (stage.slot < 4)
+        {
+            stage.type = HighPass;
+            stage.q = butterworthQ(2 * (lowCutSlope + 1), stage.slot);
+            usesLowCut = true;
+        }
+        else if (stage.slot == 4)
+        {
+            stage.type = Bell;
+            usesPeak = true;
+        }
+        else
+        {
+            stage.type = LowPass;
+            stage.q = butterworthQ(2 * (highCutSlope + 1), stage.slot - 5);
+            usesHighCut = true;
+        }
+    }
+
+    numStages = numActiveStages;
+    updateCoefficients();
+}
+
+void StereoSvfCascade::setTargets(const EqTargets& targets, bool glide)
+{
+    auto setTarget = [glide](auto& smoother, float value, bool used)
+    {
+        if (glide && used)
+            smoother.setTargetValue(value);
+        else
+            smoother.setCurrentAndTargetValue(value);
+    };
+
+    // same lower limit as the juce::dsp designs
+    setTarget(lowCutFreq, juce::jmax(2.f, targets.lowCutFreq), usesLowCut);
+    setTarget(peakFreq, juce::jmax(2.f, targets.peakFreq), usesPeak);
+    setTarget(peakGain, targets.peakGainInDecibels, usesPeak);
+    setTarget(peakQuality, targets.peakQuality, usesPeak);
+    setTarget(highCutFreq, juce::jmax(2.f, targets.highCutFreq), usesHighCut);
+
+    if (!glide)
+        updateCoefficients();
+}
+
+bool StereoSvfCascade::isGliding() const
+{
+    return lowCutFreq.isSmoothing() || peakFreq.isSmoothing() || peakGain.isSmoothing()
+        || peakQuality.isSmoothing() || highCutFreq.isSmoothing();
+}
+
+void StereoSvfCascade::takeStateFrom(const StereoBiquadCascade& cascade, const BiquadCoefficients* slotCoefficients)
+{
+    // the SVFs are still tuned to where the biquads are, the glide starts with the next control update
+    updateCoefficients();
+    samplesToNextUpdate = 0;
+
+    for (int k = 0; k < numStages; ++k)
+    {
+        const auto& stage = stages[(size_t)k];
+        const auto& c = slotCoefficients[stage.slot];
+        const auto r = getZeroInputResponse(stage);
+        const auto det = r.r00 * r.r11 - r.r01 * r.r10;
+        // a bell at 0 dB passes its input straight through, no state of it can be heard
+        const auto solvable = std::abs(det) > 1.0e-12;
+        auto& s = state[(size_t)stage.slot];
+
+        for (size_t ch = 0; ch < 2; ++ch)
+        {
+            // transposed direct form II with no input puts out s1, then s2 - a1 * s1
+            float s1, s2;
+            cascade.getSlotState(stage.slot, (int)ch, s1, s2);
+            const auto z0 = (double)s1;
+            const auto z1 = (double)s2 - (double)c.a1 * s1;
+
+            s.ic1.set(ch, solvable ? (float)((z0 * r.r11 - r.r01 * z1) / det) : 0.f);
+            s.ic2.set(ch, solvable ? (float)((r.r00 * z1 - r.r10 * z0) / det) : 0.f);
+        }
+    }
+}
+
+void StereoSvfCascade::handStateTo(StereoBiquadCascade& cascade, const BiquadCoefficients* slotCoefficients) const
+{
+    for (int k = 0; k < numStages; ++k)
+    {
+        const auto& stage = stages[(size_t)k];
+        const auto& c = slotCoefficients[stage.slot];
+        const auto r = getZeroInputResponse(stage);
+        const auto& s = state[(size_t)stage.slot];
+
+        for (size_t ch = 0; ch < 2; ++ch)
+        {
+            const auto ic1 = (double)s.ic1.get(ch), ic2 = (double)s.ic2.get(ch);
+            const auto z0 = r.r00 * ic1 + r.r01 * ic2;
+            const auto z1 = r.r10 * ic1 + r.r11 * ic2;
+            cascade.setSlotState(stage.slot, (int)ch, (float)z0, (float)(z1 + c.a1 * z0));
+        }
+    }
+}
+
+float StereoSvfCascade::prewarp(float frequency) const
+{
+    return (float)std::tan(juce::MathConstants<double>::pi * juce::jmin((double)frequency, 0.49 * sampleRate) / sampleRate);
+}
+
+void StereoSvfCascade::updateCoefficients()
+{
+    const auto lowCutG = prewarp(lowCutFreq.getCurrentValue());
+    const auto peakG = prewarp(peakFreq.getCurrentValue());
+    const auto highCutG = prewarp(highCutFreq.getCurrentValue());
+    // same A as the RBJ peak filter, k = 1 / (Q A) and the band is boosted by A^2
+    const auto a = juce::Decibels::decibelsToGain(peakGain.getCurrentValue() / 2.f);
+
+    for (int k = 0; k < numStages; ++k)
+    {
+        auto& s = stages[(size_t)k];
+        float g = 0.f, damping = 0.f;
+
+        switch (s.type)
+        {
+        case HighPass:
+            g = lowCutG;
+            damping = 1.f / s.q;
+            s.m0 = 1.f; s.m1 = -damping; s.m2 = -1.f;
+            break;
+        case Bell:
+            g = peakG;
+            damping = 1.f / (peakQuality.getCurrentValue() * a);
+            s.m0 = 1.f; s.m1 = damping * (a * a - 1.f); s.m2 = 0.f;
+            break;
+        case LowPass:
+            g = highCutG;
+            damping = 1.f / s.q;
+            s.m0 = 0.f; s.m1 = 0.f; s.m2 = 1.f;
+            break;
+        }
+
+        s.a1 = 1.f / (1.f + g * (g + damping));
+        s.a2 = g * s.a1;
+        s.a3 = g * s.a2;
+
+        stageVecs[(size_t)k] = { Vec::expand(s.a1), Vec::expand(s.a2), Vec::expand(s.a3),
+                                 Vec::expand(s.m0), Vec::expand(s.m1), Vec::expand(s.m2) };
+    }
+}
+
+void StereoSvfCascade::process(const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numChannels = (int)block.getNumChannels();
+    if (numStages == 0 || numChannels == 0)
+        return;
+
+    auto* left = block.getChannelPointer(0);
+    auto* right = numChannels > 1 ? block.getChannelPointer(1) : nullptr;
+    const auto numSamples = (int)block.getNumSamples();
+    auto* raw = reinterpret_cast<float*>(frames.data());
+    constexpr auto stride = (int)Vec::SIMDNumElements;
+
+    for (int start = 0; start < numSamples;)
+    {
+        if (samplesToNextUpdate == 0)
+        {
+            for (auto* smoother : { &lowCutFreq, &peakFreq, &highCutFreq })
+                smoother->skip(controlInterval);
+            for (auto* smoother : { &peakGain, &peakQuality })
+                smoother->skip(controlInterval);
+
+            updateCoefficients();
+            samplesToNextUpdate = controlInterval;
+        }
+
+        // up to the next control update, which may be in the next block
+        const auto n = juce::jmin(samplesToNextUpdate, numSamples - start);
+
+        for (int i = 0; i < n; ++i)
+        {
+            raw[i * stride] = left[start + i];
+            raw[i * stride + 1] = right != nullptr ? right[start + i] : 0.f;
+        }
+
+        for (int k = 0; k < numStages; ++k)
+        {
+            const auto& c = stageVecs[(size_t)k];
+            auto& st = state[(size_t)stages[(size_t)k].slot];
+            auto ic1 = st.ic1, ic2 = st.ic2;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const auto x = frames[(size_t)i];
+                const auto v3 = x - ic2;
+                const auto v1 = Vec::multiplyAdd(c.a1 * ic1, c.a2, v3);
+                const auto v2 = Vec::multiplyAdd(Vec::multiplyAdd(ic2, c.a2, ic1), c.a3, v3);
+                ic1 = v1 + v1 - ic1;
+                ic2 = v2 + v2 - ic2;
+                frames[(size_t)i] = Vec::multiplyAdd(Vec::multiplyAdd(c.m0 * x, c.m1, v1), c.m2, v2);
+            }
+
+            st.ic1 = ic1;
+            st.ic2 = ic2;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            left[start + i] = raw[i * stride];
+            if (right != nullptr)
+                right[start + i] = raw[i * stride + 1];
+        }
+
+        samplesToNextUpdate -= n;
+        start += n;
+    }
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    StereoSvfCascade.h
+    Created: 16 Oct 2026 7:24:38pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StereoBiquadCascade.h"
+
+// the parameters the EQ bands are designed from, what the smoothed mode glides between
+struct EqTargets
+{
+    float lowCutFreq{ 20.f }, peakFreq{ 1500.f }, peakGainInDecibels{ 0.f }, peakQuality{ 1.f }, highCutFreq{ 20000.f };
+};
+
+/**
+ the same EQ as StereoBiquadCascade, as trapezoidal (TPT) state variable filters, for while parameters move.
+ Frequency, gain and Q are smoothed and the filters are retuned from them every controlInterval samples,
+ on a grid that runs on across blocks, so how smooth automation sounds doesn't depend on the host block size.
+ Unlike direct form biquads the SVF stays well behaved while its coefficients change.
+ Tuned to the same frequency, Q and gain an SVF section has exactly the response of the juce::dsp design
+ it stands in for, so the filter state can be handed over to the biquads and back without a click
+ (takeStateFrom / handStateTo) and the biquads do the work whenever nothing moves.
+ State slots are the ones of StereoBiquadCascade: 0-3 low cut, 4 peak, 5-8 high cut.
+ */
+class StereoSvfCascade
+{
+public:
+    static constexpr int MaxStages = StereoBiquadCascade::MaxStages;
+    static constexpr int controlInterval = 16;
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // audio thread, none of these allocate
+    /** stages in processing order as handed to StereoBiquadCascade, slopes as in CoefficientSet */
+    void setLayout(const int* slotIds, int numActiveStages, int lowCutSlope, int highCutSlope);
+    /** glides there from where the bands are now, or jumps. Bands without an active stage always jump */
+    void setTargets(const EqTargets& targets, bool glide);
+    bool isGliding() const;
+
+    /** slotCoefficients[slot] is what the biquad cascade runs in that slot */
+    void takeStateFrom(const StereoBiquadCascade& cascade, const BiquadCoefficients* slotCoefficients);
+    void handStateTo(StereoBiquadCascade& cascade, const BiquadCoefficients* slotCoefficients) const;
+
+    /** processes channel 0 and, if present, channel 1 of the block in place */
+    void process(const juce::dsp::AudioBlock<float>& block);
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    enum StageType { HighPass, Bell, LowPass };
+
+    struct Stage
+    {
+        StageType type = Bell;
+        int slot = 0;
+        float q = 1.f;   // of the Butterworth section for the cuts
+
+        // g = tan(pi f / fs), k = 1 / Q, y = m0 x + m1 v1 + m2 v2
+        float a1 = 1.f, a2 = 0.f, a3 = 0.f, m0 = 1.f, m1 = 0.f, m2 = 0.f;
+    };
+
+    struct StageVec
+    {
+        Vec a1, a2, a3, m0, m1, m2;
+    };
+
+    struct State
+    {
+        Vec ic1, ic2;
+    };
+
+    void updateCoefficients();
+    float prewarp(float frequency) const;
+
+    double sampleRate = 44100.0;
+
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> lowCutFreq, peakFreq, highCutFreq;
+    juce::SmoothedValue<float> peakGain, peakQuality;
+    int samplesToNextUpdate = 0;
+    bool usesLowCut = false, usesPeak = false, usesHighCut = false;
+
+    std::array<Stage, MaxStages> stages;
+    std::array<StageVec, MaxStages> stageVecs;
+    std::array<State, MaxStages> state;
+    int numStages = 0;
+
+    // interleaved frames of one control interval, lane 0 = left, lane 1 = right
+    std::array<Vec, controlInterval> frames;
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Created: 16 Oct 2026 6:37:05pm
+    Author:  knize
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ single writer / single reader mailbox that always hands the reader the most recently pushed value.
+ push() and pull() never block or allocate, values pushed faster than they are pulled are simply replaced.
+ For values that own memory (paths made off the message thread) there are swapIn() / swapOut(), which
+ exchange with the buffer instead of copying - what comes back is an old value to be overwritten.
+ */
+template<typename T>
+struct TripleBuffer
+{
+    void push(const T& t)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "push() is meant for plain data, copying T must not allocate - use swapIn()");
+        buffers[backIndex] = t;
+        publish();
+    }
+
+    bool pull(T& t)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "pull() is meant for plain data, copying T must not allocate - use swapOut()");
+        if (!take())
+            return false;
+
+        t = buffers[frontIndex];
+        return true;
+    }
+
+    void swapIn(T& t)
+    {
+        std::swap(buffers[backIndex], t);
+        publish();
+    }
+
+    bool swapOut(T& t)
+    {
+        if (!take())
+            return false;
+
+        std::swap(t, buffers[frontIndex]);
+        return true;
+    }
+private:
+    void publish()
+    {
+        // hand the filled buffer over as fresh, take back whichever buffer was in the middle
+        backIndex = middle.exchange(backIndex | freshBit) & indexMask;
+    }
+
+    bool take()
+    {
+        if ((middle.load() & freshBit) == 0)
+            return false;
+
+        frontIndex = middle.exchange(frontIndex) & indexMask;
+        return true;
+    }
+
+    static constexpr int indexMask = 3, freshBit = 4;
+    std::array<T, 3> buffers{};
+    std::atomic<int> middle{ 1 };
+    int backIndex = 0, frontIndex = 2;
+};